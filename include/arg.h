@@ -8,6 +8,8 @@ typedef struct Arg_ {
   struct Vector_ lib;
   struct Vector_ config;
   struct SoundInfo_ *si;
+  m_str zygote;
+  m_uint thread;
   m_bool loop;
   m_bool quit;
 } Arg;
@@ -19,6 +19,9 @@ typedef struct BBQ_ {
   volatile uint64_t pos;
   m_float* in;
   m_float* out;
+  m_float* bin;  // block mode: captured input frames
+  m_float* bout; // block mode: rendered output frames
+  uint32_t bidx, blen;
   struct SoundInfo_ *si;
   f_bbqset func;
   f_bbqrun run;
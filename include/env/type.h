@@ -1,6 +1,19 @@
 #ifndef __TYPE
 #define __TYPE
 
+struct ReleaseItem_ {
+  m_uint offset;
+  Type   type; // NULL for objects
+};
+
+// compound members of one class level, or of a struct's tuple
+struct ReleasePlan_ {
+  m_uint n;
+  struct ReleaseItem_ item[];
+};
+
+#define TYPE_DISPLAY 8 // deeper hierarchies walk the parents
+
 struct TypeInfo_ {
   Type parent;
   Nspc owner;
@@ -14,6 +27,10 @@ struct TypeInfo_ {
   struct TupleForm_* tuple;
   struct VM_Code_ *gack;
   struct Context_ *ctx;
+  struct ReleasePlan_ *release; // built on first use
+  Type display[TYPE_DISPLAY]; // ancestors, root first
+  uint32_t level; // length of the parent chain
+  uint32_t epoch; // display is stale when this lags behind
 };
 
 enum tflag {
@@ -53,10 +70,11 @@ FLAG_FUNC(Type, t)
 ANN2(1,2) ANEW Type new_type(MemPool, const m_str name, const Type);
 ANEW ANN Type type_copy(MemPool, const Type type);
 ANN Value find_value(const Type, const Symbol);
-ANN m_bool isa(const Type, const Type) __attribute__((pure));
+ANN m_bool isa(const Type, const Type); // may refresh the display
+ANN2(1) Type set_parent(const Type, const Type);
 ANN m_bool isres(const Env, const Symbol, const loc_t pos);
 ANN Type array_type(const Env, const Type, const m_uint);
-ANN Type find_common_anc(const Type, const Type) __attribute__((pure));
+ANN Type find_common_anc(const Type, const Type);
 ANN Type typedef_base(Type) __attribute__((pure));
 ANN Type array_base(Type) __attribute__((pure));
 ANN m_bool type_ref(Type) __attribute__((pure));
@@ -15,7 +15,8 @@ enum vflag {
   vflag_direct    = 1 << 4,
   vflag_builtin    = 1 << 5,
   vflag_member   = 1 << 6,
-  vflag_closed   = 1 << 7
+  vflag_closed   = 1 << 7,
+  vflag_stack    = 1 << 8 // object kept in the frame, see noescape.c
 //  vflag_used = 1 << 3
 } __attribute__((packed));
 
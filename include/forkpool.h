@@ -0,0 +1,13 @@
+#ifndef __FORKPOOL
+#define __FORKPOOL
+typedef void (*f_forkpool)(void*);
+typedef struct ForkPool_ * ForkPool;
+ANN ForkPool new_forkpool(MemPool, const m_uint);
+ANN void free_forkpool(MemPool, ForkPool);
+ANN void forkpool_launch(const ForkPool, const f_forkpool, void*, volatile m_uint*);
+ANN void forkpool_join(const ForkPool, volatile m_uint*);
+ANN struct Gwion_* forkpool_get(const ForkPool);
+ANN m_bool forkpool_put(const ForkPool, struct Gwion_*);
+ANN m_uint forkpool_instances(const ForkPool);
+ANN void forkpool_child(const ForkPool);
+#endif
@@ -5,10 +5,10 @@ typedef struct GwionData_ {
   struct Map_ id;
   MUTEX_TYPE mutex;
   struct Vector_ child;
-  struct Vector_ child2;
   struct Vector_ reserved;
   struct Passes_  *passes;
   struct Map_ plug;
+  struct ForkPool_ *forkpool; // shared with the children
 } GwionData;
 
 ANN GwionData* new_gwiondata(MemPool);
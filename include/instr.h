@@ -53,6 +53,15 @@ INSTR(VarargIni);
 INSTR(DotTmpl);
 INSTR(GTmpl);
 
+#define DOTTMPL_CACHE 4
+struct dottmpl_cache_ {
+  m_uint seq; // odd while the entry is being filled
+  void *key; // receiver type for DotTmpl, function for GTmpl
+  VM_Code code;
+  m_uint gen;
+  m_bool member;
+};
+
 struct dottmpl_ {
   size_t len;
   m_str name;
@@ -61,8 +70,11 @@ struct dottmpl_ {
   Nspc owner;
   Type_List tl;
   void* xfun;// (type is f_xfun)
+  struct dottmpl_cache_ cache[DOTTMPL_CACHE];
+  m_uint next;
 };
 ANN void free_dottmpl(struct dottmpl_*);
+void dottmpl_invalidate(void);
 ANN m_bool traverse_dot_tmpl(const Emitter emit, const struct dottmpl_ *dt);
 
 INSTR(SetFunc);
@@ -15,4 +15,5 @@ ANN m_bool import_object_op(const Gwi gwi);
 ANN m_bool import_values(const Gwi gwi);
 ANN m_bool import_union(const Gwi gwi);
 ANN m_bool import_ref(const Gwi gwi);
+ANN m_bool import_channel(const Gwi gwi);
 #endif
@@ -2,18 +2,23 @@
 #define __OBJECT
 typedef struct M_Object_  * M_Object;
 struct M_Object_ {
-  m_bit* data;
-  Type type_ref;
-  struct Vector_ vtable;
+  Type type_ref; // moves up the parents while dtors run
+  Type type;     // the type it was made with, holds the vtable
   volatile size_t ref;
+  size_t gc; // 1 + its slot in the gc of the shred that made it, 0 for none
+  m_bit data[]; // members live right after the header
 };
 
+#define OBJECT_SIZE(t) (sizeof(struct M_Object_) + ((t)->nspc ? (t)->nspc->info->offset : 0))
+#define VTABLE(o) ((o)->type->nspc->info->vtable.ptr)
+
 ANN void instantiate_object(const VM_Shred, const Type);
 ANN void free_object(MemPool p, const M_Object);
 ANEW M_Object new_object(MemPool, const VM_Shred, const Type);
 ANEW struct UGen_* new_UGen(MemPool);
 ANEW M_Object new_M_UGen(const struct Gwion_*);
 ANN void fork_clean(const VM_Shred, const Vector);
+ANN void fork_retire(const VM_Shred);
 ANN ANEW M_Object new_array(MemPool, const Type t, const m_uint length);
 ANEW M_Object new_string(MemPool, const VM_Shred, const m_str);
 ANEW M_Object new_string2(const struct Gwion_*, const VM_Shred, const m_str);
@@ -21,16 +26,57 @@ ANEW M_Object new_shred(const VM_Shred);
 ANN void fork_launch(const M_Object, const m_uint);
 ANN void __release(const M_Object, const VM_Shred);
 ANN void exception(const VM_Shred, const m_str);
-ANN void broadcast(const M_Object);
+ANN void event_ini(MemPool, const M_Object);
+ANN void event_wait(const M_Object, const VM_Shred);
+ANN2(1) void broadcast(const M_Object, const Shreduler from);
 
 #define STRING(o)    (*(m_str*)    ((M_Object)o)->data)
 #define ME(o)        (*(VM_Shred*) ((M_Object)o)->data)
-#define EV_SHREDS(o) (*(struct Vector_*)  ((M_Object)o)->data)
+#define EV_QUEUE(o)  (*(struct EventQueue_**) ((M_Object)o)->data)
 #define UGEN(o)      (*(UGen*)     ((M_Object)o)->data)
 #define ARRAY(o)     (*(M_Vector*) ((M_Object)o)->data)
 #define IO_FILE(o)   (*(FILE**)    (((M_Object)o)->data + SZ_INT))
 #define Except(s, c) { exception(s, c); return; }
 
+#define GC_DEAD ((vtype)1) // released below the top of a shred's gc
+#define GC_STACK ((size_t)-1) // lives in a shred's mem, see noescape.c
+
+// the shred keeps them listed, so that an exception still releases their members
+ANN static inline M_Object stack_object(const VM_Shred shred, m_bit *const mem, const Type t) {
+  const M_Object o = (M_Object)mem;
+  memset(o, 0, OBJECT_SIZE(t));
+  o->ref = 1;
+  o->type_ref = o->type = t;
+  o->gc = GC_STACK;
+  vector_add(&shred->frame, (vtype)o);
+  return o;
+}
+
+ANN static inline void shred_frame_rem(const VM_Shred shred, const M_Object o) {
+  const Vector v = &shred->frame;
+  for(m_uint i = vector_size(v) + 1; --i;) { // usually the last one
+    if(vector_at(v, i - 1) == (vtype)o) {
+      vector_rem(v, i - 1);
+      return;
+    }
+  }
+}
+
+ANN static inline void shred_gc_add(const VM_Shred shred, const M_Object o) {
+  vector_add(&shred->gc, (vtype)o);
+  o->gc = vector_size(&shred->gc);
+}
+
+ANN static inline void shred_gc_rem(const VM_Shred shred, const M_Object o) {
+  const Vector v = &shred->gc;
+  const m_uint slot = o->gc;
+  if(!slot || slot > vector_size(v) || vector_at(v, slot - 1) != (vtype)o)
+    return;
+  VPTR(v, slot - 1) = GC_DEAD;
+  while(vector_size(v) && vector_back(v) == GC_DEAD)
+    vector_pop(v);
+}
+
 static inline void _release(const restrict M_Object obj, const restrict VM_Shred shred) {
   if(!--obj->ref)__release(obj, shred);
 }
@@ -42,15 +88,20 @@ typedef void (f_release)(const VM_Shred shred, const Type t NUSED, const m_bit*
 static inline RELEASE_FUNC(object_release) { release(*(M_Object*)ptr, shred); }
 RELEASE_FUNC(struct_release);
 
+ANN const struct ReleasePlan_* release_plan_ini(const struct Gwion_*, const Type);
+ANN static inline const struct ReleasePlan_* release_plan(const struct Gwion_ *gwion, const Type t) {
+  const struct ReleasePlan_ *plan = __atomic_load_n(&t->info->release, __ATOMIC_ACQUIRE);
+  return plan ?: release_plan_ini(gwion, t);
+}
+
 static inline void struct_addref(const Gwion gwion, const Type type, const m_bit* ptr) {
-  for(m_uint i = 0; i < vector_size(&type->info->tuple->types); ++i) {
-    const Type t = (Type)vector_at(&type->info->tuple->types, i);
-    if(isa(t, gwion->type[et_object]) > 0) {
-      const M_Object o = *(M_Object*)(ptr + vector_at(&type->info->tuple->offset, i));
-      ++o->ref;
-    } else if(tflag(t, tflag_struct)) {
-      struct_addref(gwion, t, *(m_bit**)(ptr + vector_at(&type->info->tuple->offset, i)));
-    }
+  const struct ReleasePlan_ *plan = release_plan(gwion, type);
+  for(m_uint i = 0; i < plan->n; ++i) {
+    const struct ReleaseItem_ *item = &plan->item[i];
+    if(!item->type)
+      ++(*(M_Object*)(ptr + item->offset))->ref;
+    else
+      struct_addref(gwion, item->type, *(m_bit**)(ptr + item->offset));
   }
 }
 
@@ -151,6 +151,7 @@ enum {
   eArrayAddr,
   eArrayValid,
   eObjectInstantiate,
+  eStackInstantiate,
   eRegAddRef,
   eRegAddRefAddr,
   eStructRegAddRef,
@@ -177,12 +178,24 @@ enum {
   eUpvalueOther,
   eUpvalueAddr,
   eDotFunc,
+  eDotFuncCache,
   eGcIni,
   eGcAdd,
   eGcEnd,
   eGackType,
   eGackEnd,
   eGack,
+  eRegPushMemImm,
+  eMemImmIntPlus,
+  eMemImmIntMinus,
+  eMemImmIntMul,
+  eMemDotMember,
+  eIntEqBranch,
+  eIntNeqBranch,
+  eIntGtBranch,
+  eIntGeBranch,
+  eIntLtBranch,
+  eIntLeBranch,
   eNoOp,
   eEOC,
   eUnroll2,
@@ -340,6 +353,7 @@ enum {
 #define  ArrayAddr            (f_instr)eArrayAddr
 #define  ArrayValid           (f_instr)eArrayValid
 #define  ObjectInstantiate    (f_instr)eObjectInstantiate
+#define  StackInstantiate     (f_instr)eStackInstantiate
 #define  RegAddRef            (f_instr)eRegAddRef
 #define  RegAddRefAddr        (f_instr)eRegAddRefAddr
 #define  StructRegAddRef      (f_instr)eStructRegAddRef
@@ -366,15 +380,232 @@ enum {
 #define  UpvalueOther         (f_instr)eUpvalueOther
 #define  UpvalueAddr          (f_instr)eUpvalueAddr
 #define  DotFunc              (f_instr)eDotFunc
+#define  DotFuncCache         (f_instr)eDotFuncCache
 #define  GcIni                (f_instr)eGcIni
 #define  GcAdd                (f_instr)eGcAdd
 #define  GcEnd                (f_instr)eGcEnd
 #define  GackType             (f_instr)eGackType
 #define  GackEnd              (f_instr)eGackEnd
 #define  Gack                 (f_instr)eGack
+#define  RegPushMemImm        (f_instr)eRegPushMemImm
+#define  MemImmIntPlus        (f_instr)eMemImmIntPlus
+#define  MemImmIntMinus       (f_instr)eMemImmIntMinus
+#define  MemImmIntMul         (f_instr)eMemImmIntMul
+#define  MemDotMember         (f_instr)eMemDotMember
+#define  IntEqBranch          (f_instr)eIntEqBranch
+#define  IntNeqBranch         (f_instr)eIntNeqBranch
+#define  IntGtBranch          (f_instr)eIntGtBranch
+#define  IntGeBranch          (f_instr)eIntGeBranch
+#define  IntLtBranch          (f_instr)eIntLtBranch
+#define  IntLeBranch          (f_instr)eIntLeBranch
 #define  NoOp                 (f_instr)eNoOp
 #define  EOC                  (f_instr)eEOC
 #define  Unroll2              (f_instr)eUnroll2
 #define  OP_MAX               (f_instr)eOP_MAX
 #define  DotTmplVal           (f_instr)eDotTmplVal
+
+#ifdef OPCODE_NAME
+static const char *opcode_name[] = {
+  "RegSetImm",
+  "RegPushImm",
+  "RegPushImm2",
+  "RegPushImm3",
+  "RegPushImm4",
+  "RegPushMem",
+  "RegPushMem2",
+  "RegPushMem3",
+  "RegPushMem4",
+  "RegPushMemDeref",
+  "RegPushNow",
+  "RegPushBase",
+  "RegPushBase2",
+  "RegPushBase3",
+  "RegPushBase4",
+  "Reg2Reg",
+  "Reg2RegOther",
+  "Reg2RegAddr",
+  "Reg2RegDeref",
+  "StructMember",
+  "StructMemberFloat",
+  "StructMemberOther",
+  "StructMemberAddr",
+  "MemSetImm",
+  "RegPushMe",
+  "RegPushMaybe",
+  "FuncReturn",
+  "Goto",
+  "AllocWord",
+  "AllocWord2",
+  "AllocWord3",
+  "int_plus",
+  "int_minus",
+  "int_mul",
+  "int_div",
+  "int_modulo",
+  "int_eq",
+  "int_neq",
+  "int_and",
+  "int_or",
+  "int_gt",
+  "int_ge",
+  "int_lt",
+  "int_le",
+  "int_sl",
+  "int_sr",
+  "int_sand",
+  "int_sor",
+  "int_xor",
+  "int_negate",
+  "IntNot",
+  "int_cmp",
+  "int_r_assign",
+  "int_r_plus",
+  "int_r_minus",
+  "int_r_mul",
+  "int_r_div",
+  "int_r_modulo",
+  "int_r_sl",
+  "int_r_sr",
+  "int_r_sand",
+  "int_r_sor",
+  "int_r_sxor",
+  "int_pre_inc",
+  "int_pre_dec",
+  "int_post_inc",
+  "int_post_dec",
+  "FloatPlus",
+  "FloatMinus",
+  "FloatTimes",
+  "FloatDivide",
+  "float_and",
+  "float_or",
+  "float_eq",
+  "float_neq",
+  "float_gt",
+  "float_ge",
+  "float_lt",
+  "float_le",
+  "float_negate",
+  "float_not",
+  "float_r_assign",
+  "float_r_plus",
+  "float_r_minus",
+  "float_r_mul",
+  "float_r_div",
+  "int_float_plus",
+  "int_float_minus",
+  "int_float_mul",
+  "int_float_div",
+  "int_float_and",
+  "int_float_or",
+  "int_float_eq",
+  "int_float_neq",
+  "int_float_gt",
+  "int_float_ge",
+  "int_float_lt",
+  "int_float_le",
+  "int_float_r_assign",
+  "int_float_r_plus",
+  "int_float_r_minus",
+  "int_float_r_mul",
+  "int_float_r_div",
+  "float_int_plus",
+  "float_int_minus",
+  "float_int_mul",
+  "float_int_div",
+  "float_int_and",
+  "float_int_or",
+  "float_int_eq",
+  "float_int_neq",
+  "float_int_gt",
+  "float_int_ge",
+  "float_int_lt",
+  "float_int_le",
+  "float_int_r_assign",
+  "float_int_r_plus",
+  "float_int_r_minus",
+  "float_int_r_mul",
+  "float_int_r_div",
+  "CastI2F",
+  "CastF2I",
+  "Time_Advance",
+  "SetCode",
+  "RegMove",
+  "Reg2Mem",
+  "Reg2Mem4",
+  "Overflow",
+  "FuncUsrEnd",
+  "FuncMemberEnd",
+  "SporkIni",
+  "ForkIni",
+  "SporkFunc",
+  "SporkMemberFptr",
+  "SporkExp",
+  "SporkEnd",
+  "BranchEqInt",
+  "BranchNeqInt",
+  "BranchEqFloat",
+  "BranchNeqFloat",
+  "Unroll",
+  "ArrayAppend",
+  "AutoUnrollInit",
+  "AutoLoop",
+  "ArrayTop",
+  "ArrayAccess",
+  "ArrayGet",
+  "ArrayAddr",
+  "ArrayValid",
+  "ObjectInstantiate",
+  "StackInstantiate",
+  "RegAddRef",
+  "RegAddRefAddr",
+  "StructRegAddRef",
+  "StructRegAddRefAddr",
+  "ObjectAssign",
+  "Assign",
+  "ObjectRelease",
+  "GWOP_EXCEPT",
+  "AllocMember4",
+  "DotMember",
+  "DotMember2",
+  "DotMember3",
+  "DotMember4",
+  "UnionCheck",
+  "UnionMember",
+  "UnionMember2",
+  "UnionMember3",
+  "UnionMember4",
+  "DotStatic",
+  "DotStatic2",
+  "DotStatic3",
+  "UpvalueInt",
+  "UpvalueFloat",
+  "UpvalueOther",
+  "UpvalueAddr",
+  "DotFunc",
+  "DotFuncCache",
+  "GcIni",
+  "GcAdd",
+  "GcEnd",
+  "GackType",
+  "GackEnd",
+  "Gack",
+  "RegPushMemImm",
+  "MemImmIntPlus",
+  "MemImmIntMinus",
+  "MemImmIntMul",
+  "MemDotMember",
+  "IntEqBranch",
+  "IntNeqBranch",
+  "IntGtBranch",
+  "IntGeBranch",
+  "IntLtBranch",
+  "IntLeBranch",
+  "NoOp",
+  "EOC",
+  "Unroll2",
+  "OP_MAX",
+  "DotTmplVal",
+};
+#endif
 #endif
@@ -2,11 +2,21 @@
 #define __SHREDULER
 struct  Shreduler_ {
   struct BBQ_ *bbq;
-  struct ShredTick_ *list;
+  struct Vector_ heap;
   struct ShredTick_ *curr;
   struct Vector_ shreds;
+  struct ShredTick_ **by_id; // open addressing on xid
+  size_t by_id_cap;
   MUTEX_TYPE mutex;
+  THREAD_COND_TYPE cond; // the driver sleeps on it while idle
+  volatile m_bool idle;
+  struct ShredTick_ *inbox; // shreds woken from any thread, lock-free
   size_t shred_ids;
+  size_t seq;
   m_bool   loop;
 };
+
+ANN static inline struct ShredTick_* shreduler_front(struct Shreduler_ *const s) {
+  return vector_size(&s->heap) ? (struct ShredTick_*)vector_at(&s->heap, 0) : NULL;
+}
 #endif
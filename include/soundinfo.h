@@ -3,6 +3,7 @@
 struct SoundInfo_ {
   m_str arg;
   uint32_t sr;
+  uint32_t block;
   uint8_t in, out;
 };
 struct SoundInfo_ *new_soundinfo(MemPool p);
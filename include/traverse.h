@@ -13,6 +13,7 @@ ANN m_bool scan0_ast(const Env, Ast);
 ANN m_bool scan1_ast(const Env, Ast);
 ANN m_bool scan2_ast(const Env, Ast);
 ANN m_bool check_ast(const Env, Ast);
+ANN m_bool noescape_ast(const Env, Ast);
 
 ANN m_bool scan1_exp(const Env, const Exp);
 ANN m_bool scan2_exp(const Env, const Exp);
@@ -2,6 +2,7 @@
 #define __UGEN
 typedef struct UGen_      * UGen;
 typedef void (*f_tick)(const UGen ug) ANN;
+typedef void (*f_block)(const UGen ug, const uint n) ANN;
 //typedef void (*f_ugop)(const UGen, const m_float) ANN;
 
 struct ugen_net_ {
@@ -21,10 +22,10 @@ struct ugen_gen {
   f_tick tick;
   void*  data;
   UGen   trig;
+  f_block block; // optional, processes n frames from bin to bout
 };
 
 struct UGen_ {
-  f_tick compute;
   union {
     struct ugen_net_ *net;
     struct ugen_multi_* multi;
@@ -34,15 +35,21 @@ struct UGen_ {
     UGen ref;
   } module;
   m_float in, out;
+  m_float *bin, *bout; // only allocated in block mode
   uint op;
   uint multi;
-  uint done;
+  uint chan; // a channel of module.ref
+  m_uint stamp; // graph generation it was last scheduled in
 };
 
 #define TICK(a) __attribute__((hot)) ANN inline void a(const UGen u)
+#define BLOCK(a) __attribute__((hot)) ANN void a(const UGen u NUSED, const uint n NUSED)
 
 ANN void ugen_ini(const struct Gwion_*, const UGen, const uint, const uint);
 ANN void ugen_gen(const struct Gwion_*, const UGen, const f_tick, void*, const m_bool);
 ANN void ugen_connect(const UGen lhs, const UGen rhs);
 ANN void ugen_disconnect(const UGen lhs, const UGen rhs);
+ANN void ugen_compute(VM *const);
+ANN void ugen_compute_block(VM *const, const uint);
+ANN m_bool ugen_idle(VM *const);
 #endif
@@ -17,6 +17,8 @@ struct VM_Code_ {
     m_uint native_func;
   };
   size_t stack_depth;
+  m_uint elided; // refcount instructions removed
+  m_uint fused;  // instructions merged into another
   void* memoize;
   Closure *closure;
   m_str name;
@@ -30,13 +32,22 @@ typedef struct Shreduler_* Shreduler;
 typedef struct Emitter_   * Emitter;
 typedef struct VM_Shred_* VM_Shred;
 
+#define SHRED_POOL 8 // stack size classes recycled by spork
+
 typedef struct VM_ {
   Shreduler shreduler;
   struct Vector_ ugen;
+  struct Vector_ ugen_sched; // UGens in evaluation order
+  size_t ugen_gen;
   struct BBQ_* bbq;
   struct Gwion_* gwion;
   VM_Shred cleaner_shred;
   struct VM_ *parent;
+  struct VMProf_ *prof; // only set by --profile
+  struct VMPar_ *par;   // only set by --jobs
+  struct Vector_ shred_pool[SHRED_POOL]; // exited shreds, by stack size
+  MUTEX_TYPE pool_mutex; // a leaf lock: shreds of this VM may be freed on any thread
+  m_uint budget;        // jumps and calls a shred may take before yielding, 0 for none
   uint32_t rand[2];
 } VM;
 
@@ -48,16 +59,24 @@ struct ShredInfo_ {
   Vector args;
   MemPool mp;
   VM_Code orig;
+  struct ShredStack_ *stack; // segments chained when a call ran out of room
+  size_t memsz; // size of the first segment, right after reg
 };
 
 struct ShredTick_ {
   VM_Shred self;
-  struct ShredTick_ *prev;
-  struct ShredTick_ *next;
   struct ShredTick_ *parent;
   struct Vector_ child;
   Shreduler shreduler;
   size_t xid;
+  size_t idx; // position in the shreduler heap, 0 when not scheduled
+  size_t seq; // keeps equal wake times in FIFO order
+  size_t resv; // seq taken ahead by vm_run_par, used by the next shredule
+  size_t slot; // position in the shreduler shreds, 0 when not registered
+  struct ShredTick_ *next; // link in the shreduler inbox
+  volatile m_uint posted; // already in the inbox
+  void (*unwait)(const VM_Shred); // leaves the queue it is parked on, when killed
+  void *waiting; // that queue
   m_float wake_time;
 };
 
@@ -66,8 +85,12 @@ struct VM_Shred_ {
   m_bit* reg;
   m_bit* mem;
   m_bit* base;
+  m_bit* stack;      // the segment mem was last checked against
+  size_t stack_size;
   size_t pc;
+  m_uint budget;     // left over from a helper thread, 0 for a fresh one
   struct Vector_ gc;
+  struct Vector_ frame; // objects living in mem, see noescape.c
   struct ShredTick_ * tick;
   struct ShredInfo_ * info;
 };
@@ -79,16 +102,33 @@ ANN VM_Shred shreduler_get(const Shreduler s) __attribute__((hot));
 ANN void shreduler_remove(const Shreduler s, const VM_Shred out, const m_bool erase)__attribute__((hot));
 ANN void shredule(const Shreduler s, const VM_Shred shred, const m_float wake_time)__attribute__((hot));
 ANN void shreduler_set_loop(const Shreduler s, const m_bool loop);
+ANN void shreduler_wake(const Shreduler s);
+ANN void shreduler_post(const Shreduler s, const VM_Shred shred);
+ANN void shreduler_signal(const Shreduler from, const VM_Shred shred);
+ANN void shreduler_drain(const Shreduler s);
+ANN void shreduler_requeue(const Shreduler s, const VM_Shred shred);
+ANN void shreduler_wake_all(const Shreduler s, VM_Shred const *shreds, const m_uint n, const m_float wake_time);
 ANN void shreduler_ini(const Shreduler s, const VM_Shred shred);
 ANN void shreduler_add(const Shreduler s, const VM_Shred shred);
+ANN VM_Shred shreduler_find(const Shreduler s, const m_uint xid);
+ANN void shreduler_release(const Shreduler s);
 
 ANEW ANN VM_Shred new_vm_shred(MemPool, const VM_Code code) __attribute__((hot));
+ANEW ANN VM_Shred new_vm_shred_sized(MemPool, const VM_Code code, const size_t depth) __attribute__((hot));
+ANEW ANN VM_Shred vm_shred_alloc(const VM*, const VM_Code code, const size_t depth);
+ANN void vm_shred_pool_release(VM*);
+ANN m_bit* shred_stack_grow(const VM_Shred, m_bit*, const m_uint, const m_bool);
 ANEW ANN VM_Shred new_shred_base(const VM_Shred, const VM_Code code) __attribute__((hot));
 __attribute__((hot))
 ANN static inline void vm_shred_exit(const VM_Shred shred) { shreduler_remove(shred->info->vm->shreduler, shred, 1); }
 void free_vm_shred(const VM_Shred shred)__attribute__((hot, nonnull));
 
 ANN void vm_run(const VM* vm) __attribute__((hot));
+ANN void vm_run_block(const VM* vm) __attribute__((hot));
+ANN void vm_skip_idle(const VM* vm);
+ANN void vm_idle_wait(const VM* vm);
+ANN void vm_reset(VM* vm);
+ANN void vm_set_jobs(VM* vm, const m_uint jobs);
 ANEW VM* new_vm(MemPool, const m_bool);
 ANN void vm_lock(VM const*);
 ANN void vm_unlock(VM const*);
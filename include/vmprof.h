@@ -0,0 +1,13 @@
+#ifndef __VMPROF
+#define __VMPROF
+
+enum vmprof_mode { vmprof_count = 1, vmprof_cycles };
+
+typedef struct VMProf_ * VMProf;
+ANN VMProf new_vmprof(MemPool, const enum vmprof_mode);
+ANN void free_vmprof(MemPool, VMProf);
+ANN void vmprof_tick(const VMProf, const VM_Code, const m_bit*);
+ANN void vmprof_stop(const VMProf);
+ANN void vmprof_forget(const VMProf, const VM_Code);
+ANN void vmprof_report(const VMProf);
+#endif
@@ -0,0 +1,4 @@
+#ifndef __ZYGOTE
+#define __ZYGOTE
+ANN m_bool zygote(const struct Gwion_*, const char*);
+#endif
@@ -20,6 +20,16 @@ do
   [ -z "$a" ] || echo "#define  $a (f_instr)e$a"
 done | column -t
 
+echo ""
+echo "#ifdef OPCODE_NAME"
+echo "static const char *opcode_name[] = {"
+for a in ${list}
+do
+  [ -z "$a" ] || echo "  \"$a\","
+done
+echo "};"
+echo "#endif"
+
 echo "#endif"
 
 echo "generated" "$COUNT" "opcodes" >&2
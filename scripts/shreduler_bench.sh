@@ -0,0 +1,26 @@
+#!/bin/bash
+# time one second of control-rate activity
+# for an increasing number of live shreds
+
+: "${PRG:=./gwion}"
+: "${SIZES:=10 100 1000 5000 10000 50000}"
+
+file=$(mktemp --suffix=.gw)
+trap 'rm -f "$file"' EXIT
+
+for n in ${SIZES}
+do
+  cat > "$file" << GW
+fun void voice(int i) {
+  while(true)
+    (1 + i % 64)::samp => now;
+}
+for(var int i; i < $n; i++)
+  spork voice(i);
+second => now;
+GW
+  start=$(date +%s.%N)
+  "$PRG" "$file" > /dev/null
+  end=$(date +%s.%N)
+  printf "%8i shreds: %8.3fs\n" "$n" "$(echo "$end - $start" | bc)"
+done
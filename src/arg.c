@@ -8,14 +8,18 @@
 #include "pass.h"
 #include "compile.h"
 #include "cmdapp.h"
+#include "vmprof.h"
 
 #define GWIONRC ".gwionrc"
 
 enum {
   CONFIG, PLUGIN, MODULE,
-  LOOP, PASS, STDIN,
+  LOOP, PASS, STDIN, ZYGOTE, THREAD, JOBS, BUDGET,
+#ifdef GWION_VMPROF
+  PROFILE,
+#endif
 // sound options
-  DRIVER, SRATE, NINPUT, NOUTPUT,
+  DRIVER, SRATE, NINPUT, NOUTPUT, BLOCK,
 // pp options
   DEFINE, UNDEF, INCLUDE,
   NOPTIONS
@@ -138,6 +142,35 @@ static void setup_options(cmdapp_t* app, cmdopt_t* opt) {
         0, NULL,
         "read from stdin", &opt[STDIN]
     );
+#ifndef BUILD_ON_WINDOWS
+    cmdapp_set(app,
+        'z', "zygote",
+        CMDOPT_TAKESARG, NULL,
+        "fork a ready instance for each request on socket ARG", &opt[ZYGOTE]
+    );
+#endif
+    cmdapp_set(app,
+        't', "threads",
+        CMDOPT_TAKESARG, NULL,
+        "keep up to ARG threads for forks (default: number of cores)", &opt[THREAD]
+    );
+    cmdapp_set(app,
+        'j', "jobs",
+        CMDOPT_TAKESARG, NULL,
+        "run shreds due at the same time on up to ARG extra threads", &opt[JOBS]
+    );
+    cmdapp_set(app,
+        'B', "budget",
+        CMDOPT_TAKESARG, NULL,
+        "kill shreds that jump or call more than ARG times without yielding", &opt[BUDGET]
+    );
+#ifdef GWION_VMPROF
+    cmdapp_set(app,
+        'P', "profile",
+        CMDOPT_TAKESARG, NULL,
+        "profile the VM, ARG is count or cycles", &opt[PROFILE]
+    );
+#endif
 // sound options
     cmdapp_set(app,
         'd', "driver",
@@ -159,6 +192,11 @@ static void setup_options(cmdapp_t* app, cmdopt_t* opt) {
         CMDOPT_TAKESARG, NULL,
         "number of output channel", &opt[NOUTPUT]
     );
+    cmdapp_set(app,
+        'b', "block",
+        CMDOPT_TAKESARG, NULL,
+        "render the UGen graph by blocks of ARG frames", &opt[BLOCK]
+    );
     cmdapp_set(app,
         'D', "define",
         CMDOPT_TAKESARG, NULL,
@@ -232,6 +270,7 @@ ANN static void config_parse(struct ArgInternal* arg, const char *name) {
 }
 
 #define ARG2INT(a) strtol(a, NULL, 10)
+#define BLOCK_MAX 8192 // frames, bin and bout are allocated for that many
 
 static void myproc(void *data, cmdopt_t* option, const char* arg) {
   struct ArgInternal *arg_int = data;
@@ -261,6 +300,26 @@ static void myproc(void *data, cmdopt_t* option, const char* arg) {
       case '\0':
         vector_add(&_arg->add, (vtype)ARG_STDIN);
         break;
+      case 'z':
+        _arg->zygote = (m_str)option->value;
+        break;
+      case 't':
+        _arg->thread = ARG2INT(option->value) > 0 ? (m_uint)ARG2INT(option->value) : 0;
+        break;
+      case 'j':
+        if(ARG2INT(option->value) > 0)
+          vm_set_jobs(arg_int->gwion->vm, (m_uint)ARG2INT(option->value));
+        break;
+      case 'B':
+        arg_int->gwion->vm->budget = ARG2INT(option->value) > 0 ? (m_uint)ARG2INT(option->value) : 0;
+        break;
+#ifdef GWION_VMPROF
+      case 'P':
+        if(!arg_int->gwion->vm->prof)
+          arg_int->gwion->vm->prof = new_vmprof(arg_int->gwion->mp,
+            strcmp(option->value, "cycles") ? vmprof_count : vmprof_cycles);
+        break;
+#endif
 // sound options
         case 's':
           _arg->si->sr = (uint32_t)ARG2INT(option->value);
@@ -274,6 +333,16 @@ static void myproc(void *data, cmdopt_t* option, const char* arg) {
         case 'o':
           _arg->si->out = (uint8_t)ARG2INT(option->value);
           break;
+        case 'b':
+        {
+          const long block = ARG2INT(option->value);
+          if(block <= 0 || block > BLOCK_MAX) {
+            gw_err(_("block size must be between 1 and %i, got '%s'\n"), BLOCK_MAX, option->value);
+            _arg->quit = 1;
+          } else
+            _arg->si->block = (uint32_t)block;
+          break;
+        }
 // pp options
         case 'D':
           add2arg(_arg, option->value, ARG_DEFINE);
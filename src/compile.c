@@ -154,6 +154,7 @@ ANN static m_uint _compile(struct Gwion_* gwion, struct Compiler* c) {
 ANN static m_uint compile(struct Gwion_* gwion, struct Compiler* c) {
   compiler_name(gwion->mp, c);
   MUTEX_LOCK(gwion->data->mutex);
+  dottmpl_invalidate();
   const m_uint ret = _compile(gwion, c);
   MUTEX_UNLOCK(gwion->data->mutex);
   compiler_clean(c);
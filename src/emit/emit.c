@@ -29,6 +29,7 @@
 typedef struct Local_ {
   Type type;
   m_uint offset;
+  m_uint size;
   uint skip;
 } Local;
 
@@ -69,12 +70,24 @@ ANN static Local* new_local(MemPool p, const Type type) {
 ANN static m_uint frame_local(MemPool p, Frame* frame, const Type t, const uint skip) {
   Local* local = new_local(p, t);
   local->offset = frame->curr_offset;
+  local->size = t->size;
   local->skip = skip;
   frame->curr_offset += t->size;
   vector_add(&frame->stack, (vtype)local);
   return local->offset;
 }
 
+// room for a whole object, the variable pointing to it is released as usual
+ANN static m_uint frame_object(MemPool p, Frame* frame, const Type t) {
+  Local* local = new_local(p, t);
+  local->offset = frame->curr_offset;
+  local->size = OBJECT_SIZE(t);
+  local->skip = 1;
+  frame->curr_offset += local->size;
+  vector_add(&frame->stack, (vtype)local);
+  return local->offset;
+}
+
 ANN static inline void frame_push(Frame* frame) {
   vector_add(&frame->stack, (vtype)NULL);
   vector_add(&frame->defer, (vtype)NULL);
@@ -182,7 +195,7 @@ ANN static m_bool emit_defers2(const Emitter emit) {
 ANN static m_int _frame_pop(const Emitter emit) {
   Frame *frame = emit->code->frame;
   DECL_OB(const Local*, l, = (Local*)vector_pop(&frame->stack))
-  frame->curr_offset -= l->type->size;
+  frame->curr_offset -= l->size;
   if(l->skip)
     return _frame_pop(emit);
   if(tflag(l->type, tflag_struct)) {
@@ -399,6 +412,14 @@ ANN2(1,2) m_bool emit_instantiate_object(const Emitter emit, const Type type,
   return GW_OK;
 }
 
+ANN static void emit_stack_object(const Emitter emit, const Type type) {
+  emit_notpure(emit);
+  const Instr instr = emit_add_instr(emit, StackInstantiate);
+  instr->m_val = frame_object(emit->gwion->mp, emit->code->frame, type);
+  instr->m_val2 = (m_uint)type;
+  emit_pre_ctor(emit, type);
+}
+
 ANN2(1,2) m_bool emit_instantiate_decl(const Emitter emit, const Type type,
       const Type_Decl *td, const Array_Sub array, const m_bool is_ref) {
   Exp base = td->array ? td->array->exp : NULL, exp = base,
@@ -783,7 +804,9 @@ ANN static m_bool emit_exp_decl_non_static(const Emitter emit, const Exp_Decl *d
   const m_bool is_array = array && array->exp;
   const m_bool is_obj = isa(type, emit->gwion->type[et_object]) > 0;
   const uint emit_addr = (!is_obj || (is_ref && !is_array)) ? emit_var : 1;
-  if(is_obj && (is_array || !is_ref))
+  if(is_obj && vflag(v, vflag_stack))
+    emit_stack_object(emit, type);
+  else if(is_obj && (is_array || !is_ref))
     CHECK_BB(emit_instantiate_decl(emit, type, decl->td, array, is_ref))
   f_instr *exec = (f_instr*)allocmember;
   if(!vflag(v, vflag_member)) {
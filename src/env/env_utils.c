@@ -66,7 +66,7 @@ ANN m_bool already_defined(const Env env, const Symbol s, const loc_t pos) {
 ANN static Type class_type(const Env env, const Type base) {
   const Type t_class = env->gwion->type[et_class];
   const Type t = type_copy(env->gwion->mp, t_class);
-  t->info->parent = t_class;
+  set_parent(t, t_class);
   t->info->ctx = base->info->ctx;
   t->info->base_type = base;
   set_tflag(t, tflag_infer);
@@ -23,6 +23,8 @@ ANN void free_type(const Type a, struct Gwion_ *const gwion) {
     nspc_remref(a->nspc, gwion);
   if(a->info->tuple)
     free_tupleform(a->info->tuple, gwion);
+  if(a->info->release)
+    xfree(a->info->release);
   mp_free(gwion->mp, TypeInfo, a->info);
   mp_free(gwion->mp, Type, a);
 
@@ -50,8 +52,47 @@ ANN Type type_copy(MemPool p, const Type type) {
   return a;
 }
 
+static uint32_t type_epoch = 1; // bumped whenever a parent changes
+
+ANN2(1) Type set_parent(const Type t, const Type parent) {
+  t->info->parent = parent;
+  __atomic_add_fetch(&type_epoch, 1, __ATOMIC_ACQ_REL);
+  return parent;
+}
+
+// forks and helper threads may rebuild the same display at once,
+// they store the same chain, but every access has to be atomic
+ANN static void type_display(const Type t, const uint32_t epoch) {
+  struct TypeInfo_ *const info = t->info;
+  uint32_t level = 0;
+  for(Type p = t; p; p = p->info->parent)
+    ++level;
+  __atomic_store_n(&info->level, level, __ATOMIC_RELAXED);
+  for(Type p = t; p; p = p->info->parent)
+    if(--level < TYPE_DISPLAY)
+      __atomic_store_n(&info->display[level], p, __ATOMIC_RELAXED);
+  __atomic_store_n(&info->epoch, epoch, __ATOMIC_RELEASE);
+}
+
+ANN static m_bool _isa(const restrict Type var, const restrict Type parent) {
+  return (var == parent) ? GW_OK : var->info->parent ? _isa(var->info->parent, parent) : GW_ERROR;
+}
+
 ANN m_bool isa(const restrict Type var, const restrict Type parent) {
-  return (var == parent) ? GW_OK : var->info->parent ? isa(var->info->parent, parent) : GW_ERROR;
+  if(var == parent)
+    return GW_OK;
+  const uint32_t epoch = __atomic_load_n(&type_epoch, __ATOMIC_ACQUIRE);
+  if(__atomic_load_n(&var->info->epoch, __ATOMIC_ACQUIRE) != epoch)
+    type_display(var, epoch);
+  if(__atomic_load_n(&parent->info->epoch, __ATOMIC_ACQUIRE) != epoch)
+    type_display(parent, epoch);
+  const uint32_t idx = __atomic_load_n(&parent->info->level, __ATOMIC_RELAXED) - 1;
+  if(idx >= __atomic_load_n(&var->info->level, __ATOMIC_RELAXED))
+    return GW_ERROR;
+  if(idx < TYPE_DISPLAY)
+    return __atomic_load_n(&var->info->display[idx], __ATOMIC_RELAXED) == parent ?
+      GW_OK : GW_ERROR;
+  return _isa(var->info->parent, parent);
 }
 
 ANN Type find_common_anc(const restrict Type lhs, const restrict Type rhs) {
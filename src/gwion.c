@@ -16,6 +16,8 @@
 #include "object.h" // fork_clean
 #include "pass.h" // fork_clean
 #include "shreduler_private.h"
+#include "vmprof.h"
+#include "forkpool.h"
 
 ANN m_bool gwion_audio(const Gwion gwion) {
   Driver *const di = gwion->vm->bbq;
@@ -24,6 +26,8 @@ ANN m_bool gwion_audio(const Gwion gwion) {
   di->func(di->driver);
   CHECK_BB(di->driver->ini(gwion->vm, di));
   driver_alloc(di);
+  if(di->si->block > 1)
+    di->run = vm_run_block;
   return GW_OK;
 }
 
@@ -38,9 +42,16 @@ ANN static void gwion_cleaner(const Gwion gwion) {
 }
 
 ANN VM* gwion_cpy(const VM* src) {
+  const Gwion old = forkpool_get(src->gwion->data->forkpool);
+  if(old) {
+    vm_reset(old->vm);
+    old->vm->budget = src->budget;
+    return old->vm;
+  }
   const Gwion gwion = mp_calloc(src->gwion->mp, Gwion);
   gwion->vm = new_vm(src->gwion->mp, 0);
   gwion->vm->gwion = gwion;
+  gwion->vm->budget = src->budget;
   gwion->vm->bbq->si = soundinfo_cpy(src->gwion->mp, src->bbq->si);
   gwion->emit = src->gwion->emit;
   gwion->env = src->gwion->env;
@@ -92,6 +103,7 @@ ANN m_bool gwion_ini(const Gwion gwion, Arg* arg) {
   pass_default(gwion);
   arg->si = gwion->vm->bbq->si = new_soundinfo(gwion->mp);
   CHECK_BB(arg_parse(gwion, arg))
+  gwion->data->forkpool = new_forkpool(gwion->mp, arg->thread);
   return !arg->quit ? gwion_ok(gwion, arg) : GW_ERROR;
 }
 
@@ -100,31 +112,40 @@ ANN void gwion_run(const Gwion gwion) {
   vm->bbq->driver->run(vm, vm->bbq);
 }
 
-ANN static inline void free_gwion_cpy(const Gwion gwion, const VM_Shred shred) {
-  gwion_end_child(shred, gwion);
+ANN static inline void free_gwion_child(const Gwion gwion) {
   free_vm(gwion->vm);
   free_gwiondata_cpy(gwion->mp, gwion->data);
   mp_free(gwion->mp, Gwion, gwion);
 }
 
-ANN static void fork_clean2(const VM_Shred shred, const Vector v) {
-  for(m_uint i = 0; i < vector_size(v); ++i) {
-    const Gwion gwion = (Gwion)vector_at(v, i);
-    free_gwion_cpy(gwion, shred);
-  }
-  vector_release(v);
-  v->ptr = NULL;
+ANN void gwion_release_child(const VM_Shred shred, const Gwion gwion) {
+  gwion_end_child(shred, gwion);
+  const Shreduler s = gwion->vm->shreduler;
+  if(vector_size(&s->shreds) || vector_size(&s->heap) ||
+     !forkpool_put(gwion->data->forkpool, gwion))
+    free_gwion_child(gwion);
 }
 
 ANN void gwion_end_child(const VM_Shred shred, const Gwion gwion) {
   if(gwion->data->child.ptr)
     fork_clean(shred, &gwion->data->child);
-  if(gwion->data->child2.ptr)
-    fork_clean2(shred, &gwion->data->child2);
 }
 
 ANN void gwion_end(const Gwion gwion) {
   gwion_end_child(gwion->vm->cleaner_shred, gwion);
+  if(gwion->data->forkpool) {
+    Gwion child;
+    while((child = forkpool_get(gwion->data->forkpool)))
+      free_gwion_child(child);
+    free_forkpool(gwion->mp, gwion->data->forkpool);
+  }
+#ifdef GWION_VMPROF
+  if(gwion->vm->prof) {
+    vmprof_report(gwion->vm->prof);
+    free_vmprof(gwion->mp, gwion->vm->prof);
+    gwion->vm->prof = NULL;
+  }
+#endif
   free_env(gwion->env);
   if(gwion->vm->cleaner_shred)
     free_vm_shred(gwion->vm->cleaner_shred);
@@ -32,6 +32,7 @@ ANN GwionData* cpy_gwiondata(MemPool mp, const GwionData* src) {
   data->reserved = src->reserved;
   data->plug = src->plug;
   data->passes = src->passes;
+  data->forkpool = src->forkpool;
   return data;
 }
 
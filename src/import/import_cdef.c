@@ -89,7 +89,7 @@ ANN2(1,2) Type gwi_class_ini(const Gwi gwi, const m_str name, const m_str parent
   t->info->cdef->base.tmpl = tmpl;
   t->info->cdef->base.type = t;
   t->info->tuple = new_tupleform(gwi->gwion->mp, p);
-  t->info->parent = p;
+  set_parent(t, p);
   if(td->array)
     set_tflag(t, tflag_typedef);
   if(ck.tmpl)
@@ -111,7 +111,7 @@ ANN Type gwi_struct_ini(const Gwi gwi, const m_str name) {
     t->info->cdef->base.type = t;
     t->info->cdef->base.tmpl = new_tmpl_base(gwi->gwion->mp, ck.tmpl);
     t->info->tuple = new_tupleform(gwi->gwion->mp, NULL);
-    t->info->parent = NULL;
+    set_parent(t, NULL);
     t->info->cdef->cflag |= cflag_struct;
     set_tflag(t, tflag_tmpl | tflag_ntmpl);
   }
@@ -645,7 +645,7 @@ INSTR(ArrayAlloc) {
     return; // TODO make exception vararg
   }
   *(void**)(ref->data + SZ_INT) = aai.data;
-  vector_add(&shred->gc, (m_uint)ref);
+  shred_gc_add(shred, ref);
   if(!info->is_obj) {
     POP_REG(shred, SZ_INT * (info->depth - 1));
     *(M_Object*)REG(-SZ_INT) = ref;
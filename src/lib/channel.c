@@ -0,0 +1,228 @@
+#include "gwion_util.h"
+#include "gwion_ast.h"
+#include "gwion_env.h"
+#include "vm.h"
+#include "gwion.h"
+#include "instr.h"
+#include "object.h"
+#include "operator.h"
+#include "import.h"
+#include "traverse.h"
+#include "parse.h"
+#include "gwi.h"
+
+#define CHANNEL(o) (*(struct Channel_**)((M_Object)o)->data)
+#define CHANNEL_CAP 256 // a power of two
+
+// bounded MPMC ring, each cell starts with its sequence number
+struct Channel_ {
+  m_bit *cell;
+  m_uint size;
+  m_uint stride;
+  volatile m_uint head;
+  m_bit pad[64 - SZ_INT]; // keep senders and receivers off the same cache line
+  volatile m_uint tail;
+  volatile m_uint nwait;
+  MUTEX_TYPE mutex; // only guards the waiters
+  struct ChanWait_ *wait; // ring of shreds blocked in recv
+  m_uint whead;
+  m_uint wlen;
+  m_uint wcap; // a power of two
+};
+
+struct ChanWait_ {
+  VM_Shred shred;
+  m_bit *ret;
+};
+
+#define WAIT_AT(c, i) (c)->wait[((c)->whead + (i)) & ((c)->wcap - 1)]
+
+#define CELL(c, pos) ((c)->cell + ((pos) & (CHANNEL_CAP - 1)) * (c)->stride)
+#define SEQ(cell) ((volatile m_uint*)(cell))
+
+ANN static m_bool chan_push(struct Channel_ *c, const m_bit *src) {
+  m_uint pos = __atomic_load_n(&c->tail, __ATOMIC_RELAXED);
+  m_bit *cell;
+  for(;;) {
+    cell = CELL(c, pos);
+    const m_int diff = (m_int)__atomic_load_n(SEQ(cell), __ATOMIC_ACQUIRE) - (m_int)pos;
+    if(!diff) {
+      if(__atomic_compare_exchange_n(&c->tail, &pos, pos + 1, 1,
+          __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else if(diff < 0)
+      return 0;
+    else
+      pos = __atomic_load_n(&c->tail, __ATOMIC_RELAXED);
+  }
+  memcpy(cell + SZ_INT, src, c->size);
+  __atomic_store_n(SEQ(cell), pos + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+ANN static m_bool chan_pop(struct Channel_ *c, m_bit *dst) {
+  m_uint pos = __atomic_load_n(&c->head, __ATOMIC_RELAXED);
+  m_bit *cell;
+  for(;;) {
+    cell = CELL(c, pos);
+    const m_int diff = (m_int)__atomic_load_n(SEQ(cell), __ATOMIC_ACQUIRE) - (m_int)(pos + 1);
+    if(!diff) {
+      if(__atomic_compare_exchange_n(&c->head, &pos, pos + 1, 1,
+          __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else if(diff < 0)
+      return 0;
+    else
+      pos = __atomic_load_n(&c->head, __ATOMIC_RELAXED);
+  }
+  memcpy(dst, cell + SZ_INT, c->size);
+  __atomic_store_n(SEQ(cell), pos + CHANNEL_CAP, __ATOMIC_RELEASE);
+  return 1;
+}
+
+static CTOR(channel_ctor) {
+  const MemPool p = shred->info->mp;
+  struct Channel_ *c = mp_calloc(p, Channel);
+  c->size = o->type_ref->info->base_type->size;
+  c->stride = SZ_INT + (c->size + SZ_INT - 1) / SZ_INT * SZ_INT;
+  c->cell = (m_bit*)xcalloc(CHANNEL_CAP, c->stride);
+  for(m_uint i = 0; i < CHANNEL_CAP; ++i)
+    *SEQ(c->cell + i * c->stride) = i;
+  MUTEX_SETUP(c->mutex);
+  CHANNEL(o) = c;
+}
+
+static DTOR(channel_dtor) {
+  struct Channel_ *c = CHANNEL(o);
+  if(c->wait)
+    xfree(c->wait);
+  MUTEX_CLEANUP(c->mutex);
+  xfree(c->cell);
+  mp_free(shred->info->mp, Channel, c);
+}
+
+ANN static void wait_grow(struct Channel_ *c) {
+  const m_uint cap = c->wcap ? c->wcap * 2 : 4;
+  struct ChanWait_ *wait = (struct ChanWait_*)xmalloc(cap * sizeof(struct ChanWait_));
+  for(m_uint i = 0; i < c->wlen; ++i)
+    wait[i] = WAIT_AT(c, i);
+  if(c->wait)
+    xfree(c->wait);
+  c->wait = wait;
+  c->whead = 0;
+  c->wcap = cap;
+}
+
+// a killed shred must not be handed a value
+ANN static void channel_unwait(const VM_Shred shred) {
+  struct Channel_ *c = (struct Channel_*)shred->tick->waiting;
+  MUTEX_LOCK(c->mutex);
+  for(m_uint i = 0; i < c->wlen; ++i) {
+    if(WAIT_AT(c, i).shred != shred)
+      continue;
+    for(m_uint j = i + 1; j < c->wlen; ++j)
+      WAIT_AT(c, j - 1) = WAIT_AT(c, j);
+    --c->wlen;
+    __atomic_sub_fetch(&c->nwait, 1, __ATOMIC_SEQ_CST);
+    break;
+  }
+  shred->tick->unwait = NULL;
+  MUTEX_UNLOCK(c->mutex);
+}
+
+// hand values straight to the shreds blocked in recv
+ANN static void channel_deliver(struct Channel_ *c) {
+  MUTEX_LOCK(c->mutex);
+  while(c->wlen) {
+    const struct ChanWait_ w = WAIT_AT(c, 0);
+    if(!chan_pop(c, w.ret))
+      break;
+    c->whead = (c->whead + 1) & (c->wcap - 1);
+    --c->wlen;
+    __atomic_sub_fetch(&c->nwait, 1, __ATOMIC_SEQ_CST);
+    w.shred->tick->unwait = NULL;
+    shreduler_post(w.shred->tick->shreduler, w.shred);
+  }
+  MUTEX_UNLOCK(c->mutex);
+}
+
+static MFUN(channel_send) {
+  struct Channel_ *c = CHANNEL(o);
+  if(!(*(m_uint*)RETURN = chan_push(c, MEM(SZ_INT))))
+    return;
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&c->nwait, __ATOMIC_RELAXED))
+    channel_deliver(c);
+}
+
+static MFUN(channel_recv) {
+  struct Channel_ *c = CHANNEL(o);
+  m_bit *const ret = (m_bit*)RETURN;
+  if(chan_pop(c, ret))
+    return;
+  MUTEX_LOCK(c->mutex);
+  __atomic_add_fetch(&c->nwait, 1, __ATOMIC_SEQ_CST);
+  if(chan_pop(c, ret))
+    __atomic_sub_fetch(&c->nwait, 1, __ATOMIC_SEQ_CST);
+  else {
+    shreduler_remove(shred->tick->shreduler, shred, 0);
+    if(c->wlen == c->wcap)
+      wait_grow(c);
+    WAIT_AT(c, c->wlen) = (struct ChanWait_){ .shred=shred, .ret=ret };
+    ++c->wlen;
+    shred->tick->waiting = c;
+    shred->tick->unwait = channel_unwait;
+  }
+  MUTEX_UNLOCK(c->mutex);
+}
+
+static MFUN(channel_size) {
+  const struct Channel_ *c = CHANNEL(o);
+  const m_int n = (m_int)__atomic_load_n(&c->tail, __ATOMIC_ACQUIRE) -
+    (m_int)__atomic_load_n(&c->head, __ATOMIC_ACQUIRE);
+  *(m_uint*)RETURN = n > 0 ? (m_uint)n : 0;
+}
+
+ANN Type scan_class(const Env env, const Type t, const Type_Decl* td);
+
+static OP_CHECK(opck_channel_scan) {
+  struct TemplateScan *ts = (struct TemplateScan*)data;
+  DECL_ON(const Type, t, = (Type)scan_class(env, ts->t, ts->td))
+  if(t->info->base_type)
+    return t;
+  const Type base = known_type(env, t->info->cdef->base.tmpl->call->td);
+  if(isa(base, env->gwion->type[et_compound]) > 0)
+    ERR_N(ts->td->pos, _("Channel can only carry primitive values, not '%s'"), base->name)
+  set_parent(t, ts->t);
+  t->info->base_type = base;
+  SET_FLAG(t, final);
+  CHECK_BN(ensure_traverse(env, t))
+  // same order as in the import
+  builtin_func(env->gwion->mp, (Func)vector_at(&t->nspc->info->vtable, 0), channel_send);
+  builtin_func(env->gwion->mp, (Func)vector_at(&t->nspc->info->vtable, 1), channel_recv);
+  builtin_func(env->gwion->mp, (Func)vector_at(&t->nspc->info->vtable, 2), channel_size);
+  return t;
+}
+
+GWION_IMPORT(channel) {
+  (void)gwi_class_ini(gwi, "Channel:[A]", "Object");
+  gwi_class_xtor(gwi, channel_ctor, channel_dtor);
+  GWI_BB(gwi_item_ini(gwi, "@internal", "@channel"))
+  GWI_BB(gwi_item_end(gwi, ae_flag_none, num, 0))
+
+  GWI_BB(gwi_func_ini(gwi, "bool", "send"))
+  GWI_BB(gwi_func_arg(gwi, "A", "val"))
+  GWI_BB(gwi_func_end(gwi, channel_send, ae_flag_none))
+
+  GWI_BB(gwi_func_ini(gwi, "A", "recv"))
+  GWI_BB(gwi_func_end(gwi, channel_recv, ae_flag_none))
+
+  GWI_BB(gwi_func_ini(gwi, "int", "size"))
+  GWI_BB(gwi_func_end(gwi, channel_size, ae_flag_none))
+  GWI_BB(gwi_class_end(gwi))
+
+  GWI_BB(gwi_oper_ini(gwi, "Channel", NULL, NULL))
+  GWI_BB(gwi_oper_add(gwi, opck_channel_scan))
+  GWI_BB(gwi_oper_end(gwi, "@scan", NULL))
+  return GW_OK;
+}
@@ -143,6 +143,7 @@ ANN static m_bool import_core_libs(const Gwi gwi) {
   GWI_BB(import_vararg(gwi))
   GWI_BB(import_string(gwi))
   GWI_BB(import_shred(gwi))
+  GWI_BB(import_channel(gwi))
   GWI_BB(import_modules(gwi))
   GWI_BB(import_ref(gwi))
 
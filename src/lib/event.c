@@ -9,42 +9,97 @@
 #include "import.h"
 #include "gwi.h"
 
+// waiting shreds, in FIFO order
+struct EventQueue_ {
+  VM_Shred *shred;
+  m_uint head;
+  m_uint len;
+  m_uint cap; // a power of two
+};
+
+#define EV_AT(q, i) (q)->shred[((q)->head + (i)) & ((q)->cap - 1)]
+
+ANN void event_ini(MemPool p, const M_Object o) {
+  EV_QUEUE(o) = mp_calloc(p, EventQueue);
+}
+
 static CTOR(event_ctor) {
-  vector_init(&EV_SHREDS(o));
+  event_ini(shred->info->mp, o);
 }
 
 static DTOR(event_dtor) {
-  vector_release(&EV_SHREDS(o));
+  struct EventQueue_ *const q = EV_QUEUE(o);
+  if(q->shred)
+    xfree(q->shred);
+  mp_free(shred->info->mp, EventQueue, q);
+}
+
+ANN static void event_grow(struct EventQueue_ *const q) {
+  const m_uint cap = q->cap ? q->cap * 2 : 4;
+  VM_Shred *shred = (VM_Shred*)xmalloc(cap * sizeof(VM_Shred));
+  for(m_uint i = 0; i < q->len; ++i)
+    shred[i] = EV_AT(q, i);
+  if(q->shred)
+    xfree(q->shred);
+  q->shred = shred;
+  q->head = 0;
+  q->cap = cap;
+}
+
+ANN void event_wait(const M_Object o, const VM_Shred shred) {
+  struct EventQueue_ *const q = EV_QUEUE(o);
+  if(q->len == q->cap)
+    event_grow(q);
+  EV_AT(q, q->len) = shred;
+  ++q->len;
 }
 
 static INSTR(EventWait) {
   POP_REG(shred, SZ_FLOAT);
   const M_Object event = *(M_Object*)REG(-SZ_INT);
   shreduler_remove(shred->tick->shreduler, shred, 0);
-  const Vector v = &EV_SHREDS(event);
-  vector_add(v, (vtype)shred);
+  event_wait(event, shred);
   *(m_int*)REG(-SZ_INT) = 1;
 }
 
 static MFUN(event_signal) {
-  const Vector v = &EV_SHREDS(o);
-  const VM_Shred sh = (VM_Shred)vector_front(v);
-  if(sh) {
-    shredule(sh->tick->shreduler, sh, GWION_EPSILON);
-    vector_rem(v, 0);
+  struct EventQueue_ *const q = EV_QUEUE(o);
+  if(q->len) {
+    const VM_Shred sh = EV_AT(q, 0);
+    q->head = (q->head + 1) & (q->cap - 1);
+    --q->len;
+    shreduler_signal(shred->tick->shreduler, sh);
   }
 }
 
-ANN void broadcast(const M_Object o) {
-  for(m_uint i = 0; i < vector_size(&EV_SHREDS(o)); i++) {
-    const VM_Shred sh = (VM_Shred)vector_at(&EV_SHREDS(o), i);
-    shredule(sh->tick->shreduler, sh, GWION_EPSILON);
+// hand each run of waiters sharing a shreduler over in one go
+ANN2(1) static void broadcast_run(VM_Shred *const shred, const m_uint len, const Shreduler from) {
+  m_uint i = 0;
+  while(i < len) {
+    const Shreduler s = shred[i]->tick->shreduler;
+    m_uint j = i + 1;
+    while(j < len && shred[j]->tick->shreduler == s)
+      ++j;
+    if(!from || s == from)
+      shreduler_wake_all(s, shred + i, j - i, GWION_EPSILON);
+    else for(m_uint k = i; k < j; ++k)
+      shreduler_post(s, shred[k]);
+    i = j;
   }
-  vector_clear(&EV_SHREDS(o));
+}
+
+ANN2(1) void broadcast(const M_Object o, const Shreduler from) {
+  struct EventQueue_ *const q = EV_QUEUE(o);
+  if(!q->len)
+    return;
+  const m_uint first = q->cap - q->head < q->len ? q->cap - q->head : q->len;
+  broadcast_run(q->shred + q->head, first, from);
+  broadcast_run(q->shred, q->len - first, from);
+  q->head = q->len = 0;
 }
 
 static MFUN(event_broadcast) {
-  broadcast(o);
+  broadcast(o, shred->tick->shreduler);
 }
 
 GWION_IMPORT(event) {
@@ -22,6 +22,51 @@ INSTR(DTOR_EOC) {
   vm_shred_exit(shred);
 }
 
+// bumped whenever new template instances may exist
+static m_uint tmpl_gen = 1;
+
+void dottmpl_invalidate(void) {
+  __atomic_add_fetch(&tmpl_gen, 1, __ATOMIC_RELEASE);
+}
+
+#define cache_load(x) __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define cache_store(x, y) __atomic_store_n(&(x), (y), __ATOMIC_RELAXED)
+
+// forks run the same code, so entries are read and filled
+// under a sequence number, a torn read is a miss
+ANN static inline m_bool dottmpl_get(struct dottmpl_ *const dt, const void *key,
+      struct dottmpl_cache_ *const ret) {
+  const m_uint gen = __atomic_load_n(&tmpl_gen, __ATOMIC_ACQUIRE);
+  for(m_uint i = 0; i < DOTTMPL_CACHE; ++i) {
+    struct dottmpl_cache_ *const c = &dt->cache[i];
+    const m_uint seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+    if(seq & 1 || cache_load(c->key) != key)
+      continue;
+    ret->code = cache_load(c->code);
+    ret->member = cache_load(c->member);
+    ret->gen = cache_load(c->gen);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(cache_load(c->seq) == seq && ret->gen == gen)
+      return 1;
+  }
+  return 0;
+}
+
+ANN static void dottmpl_set(struct dottmpl_ *const dt, const void *key, const VM_Code code, const m_bool member) {
+  const m_uint i = __atomic_fetch_add(&dt->next, 1, __ATOMIC_RELAXED);
+  struct dottmpl_cache_ *const c = &dt->cache[i % DOTTMPL_CACHE];
+  m_uint seq = cache_load(c->seq);
+  if(seq & 1 || !__atomic_compare_exchange_n(&c->seq, &seq, seq + 1, 0,
+      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    return; // someone else is filling it
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  cache_store(c->code, code);
+  cache_store(c->member, member);
+  cache_store(c->gen, __atomic_load_n(&tmpl_gen, __ATOMIC_ACQUIRE));
+  cache_store(c->key, (void*)key);
+  __atomic_store_n(&c->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
 ANN static Func_Def from_base(const Env env, struct dottmpl_ *const dt, const Nspc nspc) {
   const Func_Def fdef = dt->def ?: dt->base;
   const Symbol sym = func_symbol(env, nspc->name, s_name(fdef->base->xid),
@@ -46,6 +91,7 @@ ANN static Func_Def from_base(const Env env, struct dottmpl_ *const dt, const Ns
 
 ANN static Func_Def traverse_tmpl(const Emitter emit, struct dottmpl_ *const dt, const Nspc nspc) {
   DECL_OO(const Func_Def, def, = from_base(emit->env, dt, nspc))
+  dottmpl_invalidate();
   CHECK_BO(traverse_dot_tmpl(emit, dt))
   if(dt->xfun)
     builtin_func(emit->gwion->mp, def->base->func, dt->xfun);
@@ -55,6 +101,11 @@ ANN static Func_Def traverse_tmpl(const Emitter emit, struct dottmpl_ *const dt,
 INSTR(GTmpl) {
   struct dottmpl_ *dt = (struct dottmpl_*)instr->m_val;
   const Func f = *(Func*)REG(-SZ_INT);
+  struct dottmpl_cache_ c;
+  if(dottmpl_get(dt, f, &c)) {
+    *(VM_Code*)(shred->reg -SZ_INT) = c.code;
+    return;
+  }
   const m_str name = f->name;
   const Emitter emit = shred->info->vm->gwion->emit;
   emit->env->name = "runtime";
@@ -67,6 +118,7 @@ INSTR(GTmpl) {
     if(base) {
       free_mstr(emit->gwion->mp, tmpl_name);
       assert(base->code);
+      dottmpl_set(dt, f, base->code, 0);
       *(VM_Code*)(shred->reg -SZ_INT) = base->code;
       return;
     }
@@ -76,6 +128,7 @@ INSTR(GTmpl) {
   const Func_Def def = traverse_tmpl(emit, dt, f->value_ref->from->owner);
   if(!def)
     Except(shred, "MissigTmplPtrException[internal]");
+  dottmpl_set(dt, f, def->base->func->code, 0);
   *(VM_Code*)(shred->reg -SZ_INT) = def->base->func->code;
 }
 
@@ -83,6 +136,13 @@ INSTR(DotTmpl) {
   struct dottmpl_ *dt = (struct dottmpl_*)instr->m_val;
   const m_str name = dt->name;
   const M_Object o = *(M_Object*)REG(-SZ_INT);
+  struct dottmpl_cache_ c;
+  if(dottmpl_get(dt, o->type_ref, &c)) {
+    if(c.member)
+      shred->reg += SZ_INT;
+    *(VM_Code*)(shred->reg-SZ_INT) = c.code;
+    return;
+  }
   Type t = o->type_ref;
   do {
     const Emitter emit = shred->info->vm->gwion->emit;
@@ -94,6 +154,7 @@ INSTR(DotTmpl) {
     if(f) {
       if(!f->code)
         break;
+      dottmpl_set(dt, o->type_ref, f->code, vflag(f->value_ref, vflag_member));
       if(vflag(f->value_ref, vflag_member))
         shred->reg += SZ_INT;
       *(VM_Code*)(shred->reg-SZ_INT) = f->code;
@@ -103,6 +164,7 @@ INSTR(DotTmpl) {
       if(!def)
         continue;
       const Func f = def->base->func;
+      dottmpl_set(dt, o->type_ref, f->code, vflag(f->value_ref, vflag_member));
       if(vflag(f->value_ref, vflag_member))
         shred->reg += SZ_INT;
       *(VM_Code*)(shred->reg-SZ_INT) = f->code;
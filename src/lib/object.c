@@ -26,16 +26,11 @@ ANN void exception(const VM_Shred shred, const m_str c) {
 }
 
 M_Object new_object(MemPool p, const VM_Shred shred, const Type t) {
-  const M_Object a = mp_calloc(p, M_Object);
+  const M_Object a = (M_Object)_mp_calloc(p, OBJECT_SIZE(t));
   a->ref = 1;
-  a->type_ref = t;
-  if(t->nspc) {
-    a->vtable.ptr = t->nspc->info->vtable.ptr;
-    if(t->nspc->info->offset)
-      a->data = (m_bit*)_mp_calloc(p, t->nspc->info->offset);
-  }
+  a->type_ref = a->type = t;
   if(shred)
-    vector_add(&shred->gc, (vtype)a);
+    shred_gc_add(shred, a);
   return a;
 }
 
@@ -62,19 +57,22 @@ ANN static void handle_dtor(const M_Object o, const VM_Shred shred) {
 
 __attribute__((hot))
 ANN void __release(const M_Object o, const VM_Shred shred) {
-  vector_rem2(&shred->gc, (vtype)o);
+  if(o->gc != GC_STACK)
+    shred_gc_rem(shred, o);
+  else
+    shred_frame_rem(shred, o);
   MemPool p = shred->info->mp;
   Type t = o->type_ref;
   do {
     if(!t->nspc)
       continue;
-    if(isa(t, shred->info->vm->gwion->type[et_union]) < 0) {
-      struct scope_iter iter = { t->nspc->info->value, 0, 0 };\
-      Value v;
-      while(scope_iter(&iter, &v) > 0) {
-        if(!GET_FLAG(v, static) && isa(v->type, shred->info->vm->gwion->type[et_compound]) > 0)
-          compound_release(shred, v->type, o->data + v->from->offset);
-      }
+    const struct ReleasePlan_ *plan = release_plan(shred->info->vm->gwion, t);
+    for(m_uint i = 0; i < plan->n; ++i) {
+      const struct ReleaseItem_ *item = &plan->item[i];
+      if(!item->type)
+        release(*(M_Object*)(o->data + item->offset), shred);
+      else
+        struct_release(shred, item->type, o->data + item->offset);
     }
     if(tflag(t, tflag_dtor)) {
       if(t->nspc->dtor->builtin)
@@ -90,9 +88,8 @@ ANN void __release(const M_Object o, const VM_Shred shred) {
 }
 
 ANN void free_object(MemPool p, const M_Object o) {
-  if(o->type_ref->nspc && o->type_ref->nspc->info->offset)
-    mp_free2(p, o->type_ref->nspc->info->offset, o->data);
-  mp_free(p, M_Object, o);
+  if(o->gc != GC_STACK)
+    _mp_free(p, OBJECT_SIZE(o->type), o);
 }
 
 static ID_CHECK(opck_this) {
@@ -98,7 +98,8 @@ ANN static void emit_member_func(const Emitter emit, const Exp_Dot* member) {
   const Func f = exp_self(member)->type->info->func;
   if(f->def->base->tmpl)
     emit_add_instr(emit, DotTmplVal);
-  else if(GET_FLAG(member->base->type, final) || is_class(emit->gwion, member->base->type) || member->base->exp_type == ae_exp_cast) {
+  else if(GET_FLAG(member->base->type, final) || is_class(emit->gwion, member->base->type) || member->base->exp_type == ae_exp_cast ||
+      (vflag(f->value_ref, vflag_member) && GET_FLAG(f->def->base, final))) {
     const Instr func_i = emit_add_instr(emit, f->code ? RegPushImm : SetFunc);
     func_i->m_val = (m_uint)f->code ?: (m_uint)f;
     return;
@@ -279,18 +280,58 @@ ANN Type scan_class(const Env env, const Type t, const Type_Decl *td) {
   return ret;
 }
 
+ANN static inline void plan_add(const Vector v, const Type t, const m_uint offset) {
+  vector_add(v, offset);
+  vector_add(v, (vtype)(tflag(t, tflag_struct) ? t : NULL));
+}
+
+// list the compound members once, so releases don't have to walk the scope
+ANN const struct ReleasePlan_* release_plan_ini(const struct Gwion_ *gwion, const Type base) {
+  const Type compound = gwion->type[et_compound];
+  struct Vector_ v;
+  vector_init(&v);
+  if(tflag(base, tflag_struct)) {
+    const Vector types   = &base->info->tuple->types;
+    const Vector offsets = &base->info->tuple->offset;
+    for(m_uint i = 0; i < vector_size(types); ++i) {
+      const Type t = (Type)vector_at(types, i);
+      if(isa(t, compound) > 0)
+        plan_add(&v, t, vector_at(offsets, i));
+    }
+  } else if(base->nspc && isa(base, gwion->type[et_union]) < 0) {
+    struct scope_iter iter = { base->nspc->info->value, 0, 0 };
+    Value value;
+    while(scope_iter(&iter, &value) > 0) {
+      if(!GET_FLAG(value, static) && isa(value->type, compound) > 0)
+        plan_add(&v, value->type, value->from->offset);
+    }
+  }
+  const m_uint n = vector_size(&v) / 2;
+  struct ReleasePlan_ *plan = (struct ReleasePlan_*)xmalloc(sizeof(struct ReleasePlan_) +
+      n * sizeof(struct ReleaseItem_));
+  plan->n = n;
+  for(m_uint i = 0; i < n; ++i) {
+    plan->item[i].offset = vector_at(&v, i*2);
+    plan->item[i].type = (Type)vector_at(&v, i*2 + 1);
+  }
+  vector_release(&v);
+  // shreds on other threads may race us here, first one wins
+  struct ReleasePlan_ *prev = NULL;
+  if(__atomic_compare_exchange_n(&base->info->release, &prev, plan, 0,
+      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    return plan;
+  xfree(plan);
+  return prev;
+}
+
 ANN void struct_release(const VM_Shred shred, const Type base, const m_bit *ptr) {
-  const Vector types   = &base->info->tuple->types;
-  const Vector offsets = &base->info->tuple->offset;
-  for(m_uint i = 0; i < vector_size(types); ++i) {
-    const Type t = (Type)vector_at(types, i);
-    if(isa(t, shred->info->vm->gwion->type[et_compound]) < 0)
-      continue;
-    const m_uint offset = vector_at(offsets, i);
-    if(!tflag(t, tflag_struct))
-      release(*(M_Object*)(ptr + offset), shred);
+  const struct ReleasePlan_ *plan = release_plan(shred->info->vm->gwion, base);
+  for(m_uint i = 0; i < plan->n; ++i) {
+    const struct ReleaseItem_ *item = &plan->item[i];
+    if(!item->type)
+      release(*(M_Object*)(ptr + item->offset), shred);
     else
-      struct_release(shred, t, *(m_bit**)(ptr + offset));
+      struct_release(shred, item->type, *(m_bit**)(ptr + item->offset));
   }
 }
 
@@ -12,16 +12,17 @@
 #include "emit.h"
 #include "specialid.h"
 #include "gwi.h"
+#include "forkpool.h"
 
-static m_int o_fork_thread, o_fork_cond, o_fork_mutex, o_shred_cancel, o_fork_done, o_fork_ev, o_fork_retsize;
+static m_int o_fork_thread, o_shred_cancel, o_fork_done, o_fork_ev, o_fork_retsize;
 
-#define FORK_THREAD(o) *(THREAD_TYPE*)(o->data + o_fork_thread)
-#define FORK_COND(o) *(THREAD_COND_TYPE*)(o->data + o_fork_cond)
-#define FORK_MUTEX(o) *(MUTEX_TYPE*)(o->data + o_fork_mutex)
+#define FORK_THREAD(o) (volatile m_uint*)(o->data + o_fork_thread)
 #define FORK_RETSIZE(o) *(m_int*)(o->data + o_fork_retsize)
 
 VM_Shred new_shred_base(const VM_Shred shred, const VM_Code code) {
-  const VM_Shred sh = new_vm_shred(shred->info->mp, code);
+  // room for the locals SporkExp copies from the parent
+  const VM_Shred sh = vm_shred_alloc(shred->info->vm, code,
+    code->stack_depth + shred->code->stack_depth);
   vmcode_addref(code);
   sh->base = shred->base;
   return sh;
@@ -38,7 +39,7 @@ ANN static inline M_Object fork_object(const VM_Shred shred, const Type t) {
   const Gwion gwion = shred->info->vm->gwion;
   const M_Object o = new_object(gwion->mp, shred, t);
   *(M_Object*)(o->data + o_fork_ev) = new_object(gwion->mp, NULL, gwion->type[et_event]);
-  vector_init(&EV_SHREDS(*(M_Object*)(o->data + o_fork_ev)));
+  event_ini(gwion->mp, *(M_Object*)(o->data + o_fork_ev));
   return o;
 }
 
@@ -68,7 +69,7 @@ static MFUN(vm_shred_id) {
 
 static MFUN(vm_shred_is_running) {
   const VM_Shred s = ME(o);
-  *(m_uint*)RETURN = (s->tick->next || s->tick->prev) ? 1 : 0;
+  *(m_uint*)RETURN = s->tick->idx ? 1 : 0;
 }
 
 static MFUN(vm_shred_is_done) {
@@ -78,23 +79,23 @@ static MFUN(vm_shred_is_done) {
 static MFUN(shred_yield) {
   const VM_Shred s = ME(o);
   const Shreduler sh = s->tick->shreduler;
-  if(s != shred)
-    shreduler_remove(sh, s, 0);
-  shredule(sh, s, GWION_EPSILON);
+  if(sh != shred->tick->shreduler) // requeued when its VM drains the inbox
+    shreduler_post(sh, s);
+  else {
+    if(s != shred)
+      shreduler_remove(sh, s, 0);
+    shredule(sh, s, GWION_EPSILON);
+  }
 }
 
 static SFUN(vm_shred_from_id) {
   const m_int index =  *(m_int*)MEM(0);
-  if(index > 0) {
-    for(m_uint i = 0; i < vector_size(&shred->tick->shreduler->shreds); ++i) {
-      const VM_Shred s = (VM_Shred)vector_at(&shred->tick->shreduler->shreds, i);
-      if(s->tick->xid == (m_uint)index) {
-        *(M_Object*)RETURN = s->info->me;
-        return;
-      }
-    }
-  }
-  *(m_uint*)RETURN = 0;
+  const VM_Shred s = index > 0 ?
+    shreduler_find(shred->tick->shreduler, (m_uint)index) : NULL;
+  if(s)
+    *(M_Object*)RETURN = s->info->me;
+  else
+    *(m_uint*)RETURN = 0;
 }
 
 static MFUN(shred_args) {
@@ -174,20 +175,19 @@ static void stop(const M_Object o) {
   MUTEX_LOCK(vm->shreduler->mutex);
   vm->shreduler->bbq->is_running = 0;
   *(m_int*)(o->data + o_shred_cancel) = 1;
+  THREAD_COND_SIGNAL(vm->shreduler->cond);
   MUTEX_UNLOCK(vm->shreduler->mutex);
 }
 
 static inline void join(const M_Object o) {
-  if(FORK_THREAD(o)) {
-    THREAD_JOIN(FORK_THREAD(o));
-    FORK_THREAD(o) = 0;
-  }
+  forkpool_join(ME(o)->info->vm->gwion->data->forkpool, FORK_THREAD(o));
 }
 
 static DTOR(fork_dtor) {
   *(m_int*)(o->data + o_fork_done) = 1;
   stop(o);
   join(o);
+  const Gwion gwion = ME(o)->info->vm->gwion;
   VM *parent = ME(o)->info->vm->parent;
   MUTEX_LOCK(parent->shreduler->mutex);
   if(parent->gwion->data->child.ptr) {
@@ -195,18 +195,19 @@ static DTOR(fork_dtor) {
     if(idx > -1)
     VPTR(&parent->gwion->data->child, idx) = 0;
   }
-  if(!parent->gwion->data->child2.ptr)
-    vector_init(&parent->gwion->data->child2);
-  vector_add(&parent->gwion->data->child2, (vtype)ME(o)->info->vm->gwion);
-  vmcode_remref(ME(o)->code, ME(o)->info->vm->gwion);
+  vmcode_remref(ME(o)->code, gwion);
   MUTEX_UNLOCK(parent->shreduler->mutex);
+  // the thread is joined, the instance can go back to the pool
+  free_vm_shred(ME(o));
+  ME(o) = NULL;
+  gwion_release_child(shred, gwion);
 }
 
 static MFUN(fork_join) {
   if(*(m_int*)(o->data + o_fork_done))
     return;
   shreduler_remove(shred->tick->shreduler, shred, 0);
-  vector_add(&EV_SHREDS(*(M_Object*)(o->data + o_fork_ev)), (vtype)shred);
+  event_wait(*(M_Object*)(o->data + o_fork_ev), shred);
 }
 
 static MFUN(shred_cancel) {
@@ -236,12 +237,6 @@ static MFUN(shred_now) {
   *(m_float*)RETURN = vm->bbq->pos;
 }
 
-struct ThreadLauncher {
-  MUTEX_TYPE mutex;
-  THREAD_COND_TYPE cond;
-  VM *vm;
-};
-
 static inline int fork_running(VM *vm, const M_Object o) {
   MUTEX_LOCK(vm->shreduler->mutex);
   const int ret = vm->bbq->is_running && !*(m_int*)(o->data + o_shred_cancel);
@@ -249,18 +244,15 @@ static inline int fork_running(VM *vm, const M_Object o) {
   return ret;
 }
 
-static ANN THREAD_FUNC(fork_run) {
-struct ThreadLauncher *tl = data;
-  VM *vm = tl->vm;
-  MUTEX_TYPE mutex = tl->mutex;
-  const M_Object me = vm->shreduler->list->self->info->me;
+static void fork_run(void *data) {
+  const M_Object me = (M_Object)data;
+  VM *vm = ME(me)->info->vm;
   ++me->ref;
-  MUTEX_COND_LOCK(mutex);
-  THREAD_COND_SIGNAL(FORK_COND(me));
-  MUTEX_COND_UNLOCK(mutex);
   while(fork_running(vm, me)) {
     vm_run(vm);
     ++vm->bbq->pos;
+    vm_skip_idle(vm);
+    vm_idle_wait(vm);
   }
   gwion_end_child(ME(me), vm->gwion);
   MUTEX_LOCK(vm->parent->shreduler->mutex);
@@ -268,22 +260,29 @@ struct ThreadLauncher *tl = data;
     memcpy(me->data + vm->gwion->type[et_fork]->nspc->info->offset, ME(me)->reg, FORK_RETSIZE(me));
   *(m_int*)(me->data + o_fork_done) = 1;
   if(!*(m_int*)(me->data + o_shred_cancel))
-    broadcast(*(M_Object*)(me->data + o_fork_ev));
+    broadcast(*(M_Object*)(me->data + o_fork_ev), NULL); // we hold the parent's lock
   MUTEX_UNLOCK(vm->parent->shreduler->mutex);
-  THREAD_RETURN(0);
 }
 
 ANN void fork_launch(const M_Object o, const m_uint sz) {
   FORK_RETSIZE(o) = sz;
-  MUTEX_SETUP(FORK_MUTEX(o));
-  THREAD_COND_SETUP(FORK_COND(o));
-  struct ThreadLauncher tl = { .mutex=FORK_MUTEX(o), .cond=FORK_COND(o), .vm=ME(o)->info->vm };
-  MUTEX_COND_LOCK(tl.mutex);
-  THREAD_CREATE(FORK_THREAD(o), fork_run, &tl);
-  THREAD_COND_WAIT(FORK_COND(o), tl.mutex);
-  MUTEX_COND_UNLOCK(tl.mutex);
-  THREAD_COND_CLEANUP(FORK_COND(o));
-  MUTEX_CLEANUP(FORK_MUTEX(o));
+  forkpool_launch(ME(o)->info->vm->gwion->data->forkpool, fork_run, o, FORK_THREAD(o));
+}
+
+// finished forks keep a reference from the parent's child list,
+// drop it so their instance is recycled before the parent ends
+ANN void fork_retire(const VM_Shred shred) {
+  const Vector v = &shred->info->vm->gwion->data->child;
+  if(!v->ptr)
+    return;
+  for(m_uint i = vector_size(v) + 1; --i;) {
+    const M_Object o = (M_Object)vector_at(v, i - 1);
+    if(o && !*(m_int*)(o->data + o_fork_done))
+      continue;
+    vector_rem(v, i - 1);
+    if(o)
+      _release(o, shred);
+  }
 }
 
 ANN void fork_clean(const VM_Shred shred, const Vector v) {
@@ -387,10 +386,6 @@ GWION_IMPORT(shred) {
 
   gwi_item_ini(gwi, "@internal", "@thread");
   GWI_BB((o_fork_thread = gwi_item_end(gwi, ae_flag_const, num, 0)))
-  gwi_item_ini(gwi, "@internal", "@cond");
-  GWI_BB((o_fork_cond = gwi_item_end(gwi, ae_flag_const, num, 0)))
-  gwi_item_ini(gwi, "@internal", "@mutex");
-  GWI_BB((o_fork_mutex = gwi_item_end(gwi, ae_flag_const, num, 0)))
   gwi_item_ini(gwi, "int", "is_done");
   GWI_BB((o_fork_done = gwi_item_end(gwi, ae_flag_const, num, 0)))
   gwi_item_ini(gwi, "Event", "ev");
@@ -27,68 +27,231 @@ static TICK(adc_tick) {
   while(++i < u->connect.multi->n_out);
 }
 
-#define COMPUTE(a) if(!(a)->done)(a)->compute((a));
+static BLOCK(dac_block) {
+  m_float* out = ((VM*)u->module.gen.data)->bbq->bout;
+  const uint n_out = u->connect.multi->n_out;
+  for(uint i = 0; i < n_out; ++i) {
+    const m_float *in = UGEN(u->connect.multi->channel[i])->bin;
+    for(uint j = 0; j < n; ++j)
+      out[j * n_out + i] = in[j];
+  }
+}
+
+static BLOCK(adc_block) {
+  const m_float* in = ((VM*)u->module.gen.data)->bbq->bin;
+  const uint n_out = u->connect.multi->n_out;
+  for(uint i = 0; i < n_out; ++i) {
+    m_float *out = UGEN(u->connect.multi->channel[i])->bout;
+    for(uint j = 0; j < n; ++j)
+      out[j] = in[j * n_out + i];
+  }
+}
+
+static TICK(hole_tick) {}
+static BLOCK(hole_block) {}
+
+/* bumped whenever the topology of the graph changes,
+ * so that VMs know their schedule is stale.
+ * forks change it from their own thread */
+static m_uint graph_gen = 1;
+#define graph_now() __atomic_load_n(&graph_gen, __ATOMIC_ACQUIRE)
+#define graph_changed() __atomic_add_fetch(&graph_gen, 1, __ATOMIC_RELEASE)
+
+ANN static void sched_visit(const Vector v, const UGen u, const m_uint stamp);
+
+ANN static void sched_from(const Vector v, const UGen u, const m_uint stamp) {
+  u->stamp = stamp;
+  const Vector vec = &u->connect.net->from;
+  for(uint i = 0; i < u->connect.net->size; ++i)
+    sched_visit(v, (UGen)vector_at(vec, i), stamp);
+}
+
+/* depth first from the dac, sources before the ugens they feed,
+ * so feedback loops still read the previous sample */
+ANN static void sched_visit(const Vector v, const UGen u, const m_uint stamp) {
+  if(u->chan) {
+    sched_visit(v, u->module.ref, stamp);
+    return;
+  }
+  if(u->stamp == stamp)
+    return;
+  if(!u->multi)
+    sched_from(v, u, stamp);
+  else {
+    u->stamp = stamp;
+    const struct ugen_multi_ *m = u->connect.multi;
+    for(uint c = 0; c < m->n_chan; ++c)
+      sched_from(v, UGEN(m->channel[c]), stamp);
+  }
+  if(u->module.gen.trig)
+    sched_from(v, u->module.gen.trig, stamp);
+  if(u->module.gen.tick)
+    vector_add(v, (vtype)u);
+}
+
+ANN static void ugen_schedule(VM *const vm) {
+  const Vector v = &vm->ugen_sched;
+  vector_clear(v);
+  vm->ugen_gen = graph_now();
+  sched_visit(v, (UGen)vector_front(&vm->ugen), vm->ugen_gen);
+}
 
 __attribute__((hot))
-ANN void compute_mono(const UGen u) {
-  u->done = 1;
+ANN static void ugen_sum(const UGen u) {
   const uint size = u->connect.net->size;
-  if(size) {
-    const Vector vec = &u->connect.net->from;
-    const UGen   v   = (UGen)vector_front(vec);
-    COMPUTE(v)
-    u->in = v->out;
-    for(uint i = 1; i < size; ++i) {
-      const UGen w = (UGen)vector_at(vec, i);
-      COMPUTE(w)
-      static const void* dispatch[] = { &&add, &&sub, &&mul, &&div };
-      do {
-        goto *dispatch[u->op];
-        add:
-          u->in += w->out;
-          break;
-        sub:
-          u->in -= w->out;
-          break;
-        mul:
-          u->in *= w->out;
-          break;
-        div:
-          u->in *= w->out;
-          break;
-      }while(0);
+  if(!size)
+    return;
+  const Vector vec = &u->connect.net->from;
+  m_float in = ((UGen)vector_front(vec))->out;
+  for(uint i = 1; i < size; ++i) {
+    const UGen w = (UGen)vector_at(vec, i);
+    switch(u->op) {
+      case 0:
+        in += w->out;
+        break;
+      case 1:
+        in -= w->out;
+        break;
+      default:
+        in *= w->out;
+        break;
     }
   }
+  u->in = in;
 }
+
 __attribute__((hot))
-ANN void compute_multi(const UGen u) {
-  u->done = 1;
-  uint i = 0;
-  do compute_mono(UGEN(u->connect.multi->channel[i]));
-  while(++i < u->connect.multi->n_chan);
+ANN static inline void ugen_step(const UGen u) {
+  if(!u->multi)
+    ugen_sum(u);
+  else {
+    const struct ugen_multi_ *m = u->connect.multi;
+    for(uint c = 0; c < m->n_chan; ++c)
+      ugen_sum(UGEN(m->channel[c]));
+  }
+  if(u->module.gen.trig)
+    ugen_sum(u->module.gen.trig);
+  u->module.gen.tick(u);
 }
 
 __attribute__((hot))
-ANN void compute_chan(const UGen u) {
-  COMPUTE(u->module.ref);
+ANN void ugen_compute(VM *const vm) {
+  if(vm->ugen_gen != graph_now())
+    ugen_schedule(vm);
+  const Vector v = &vm->ugen_sched;
+  LOOP_OPTIM
+  for(m_uint i = 0; i < vector_size(v); ++i)
+    ugen_step((UGen)vector_at(v, i));
 }
 
-#define describe_compute(func, opt, aux)         \
-__attribute__((hot))                             \
-ANN void gen_compute_##func##opt(const UGen u) { \
-  compute_##func(u);                             \
-  aux                                            \
-  u->module.gen.tick(u);                                \
+__attribute__((hot))
+ANN static void block_sum(const UGen u, const uint n) {
+  const uint size = u->connect.net->size;
+  m_float *const bin = u->bin;
+  if(!size) {
+    for(uint i = 0; i < n; ++i)
+      bin[i] = u->in;
+    return;
+  }
+  const Vector vec = &u->connect.net->from;
+  memcpy(bin, ((UGen)vector_front(vec))->bout, n * SZ_FLOAT);
+  for(uint i = 1; i < size; ++i) {
+    const m_float *const in = ((UGen)vector_at(vec, i))->bout;
+    switch(u->op) {
+      case 0:
+        for(uint j = 0; j < n; ++j)
+          bin[j] += in[j];
+        break;
+      case 1:
+        for(uint j = 0; j < n; ++j)
+          bin[j] -= in[j];
+        break;
+      default:
+        for(uint j = 0; j < n; ++j)
+          bin[j] *= in[j];
+        break;
+    }
+  }
+}
+
+__attribute__((hot))
+ANN static void block_mono(const UGen u, const UGen trig, const uint n) {
+  for(uint i = 0; i < n; ++i) {
+    u->in = u->bin[i];
+    if(trig)
+      trig->in = trig->bin[i];
+    u->module.gen.tick(u);
+    u->bout[i] = u->out;
+  }
+}
+
+__attribute__((hot))
+ANN static void block_multi(const UGen u, const UGen trig, const uint n) {
+  const struct ugen_multi_ *m = u->connect.multi;
+  for(uint i = 0; i < n; ++i) {
+    for(uint c = 0; c < m->n_chan; ++c) {
+      const UGen chan = UGEN(m->channel[c]);
+      chan->in = chan->bin[i];
+    }
+    if(trig)
+      trig->in = trig->bin[i];
+    u->module.gen.tick(u);
+    for(uint c = 0; c < m->n_chan; ++c) {
+      const UGen chan = UGEN(m->channel[c]);
+      chan->bout[i] = chan->out;
+    }
+  }
+}
+
+__attribute__((hot))
+ANN static void block_step(const UGen u, const uint n) {
+  if(!u->multi)
+    block_sum(u, n);
+  else {
+    const struct ugen_multi_ *m = u->connect.multi;
+    for(uint c = 0; c < m->n_chan; ++c)
+      block_sum(UGEN(m->channel[c]), n);
+  }
+  const UGen trig = u->module.gen.trig;
+  if(trig)
+    block_sum(trig, n);
+  if(u->module.gen.block)
+    u->module.gen.block(u, n);
+  else if(!u->multi)
+    block_mono(u, trig, n);
+  else
+    block_multi(u, trig, n);
+}
+
+__attribute__((hot))
+ANN void ugen_compute_block(VM *const vm, const uint n) {
+  if(vm->ugen_gen != graph_now())
+    ugen_schedule(vm);
+  const Vector v = &vm->ugen_sched;
+  LOOP_OPTIM
+  for(m_uint i = 0; i < vector_size(v); ++i)
+    block_step((UGen)vector_at(v, i), n);
+}
+
+/* true when nothing but blackhole and dac would be computed,
+ * so that rendering a sample has no effect */
+ANN m_bool ugen_idle(VM *const vm) {
+  if(!vector_size(&vm->ugen))
+    return 1;
+  if(vm->ugen_gen != graph_now())
+    ugen_schedule(vm);
+  const Vector v = &vm->ugen_sched;
+  for(m_uint i = 0; i < vector_size(v); ++i) {
+    const vtype u = vector_at(v, i);
+    if(u != vector_at(&vm->ugen, 0) && u != vector_at(&vm->ugen, 1))
+      return 0;
+  }
+  return 1;
 }
-describe_compute(mono,,)
-describe_compute(multi,,)
-describe_compute(mono,  trig, {u->module.gen.trig->compute(u->module.gen.trig);})
-describe_compute(multi, trig, {u->module.gen.trig->compute(u->module.gen.trig);})
 
 ANEW UGen new_UGen(MemPool p) {
   const UGen u = mp_calloc(p, UGen);
   u->op = 0;
-  u->compute = gen_compute_mono;
   return u;
 }
 
@@ -100,14 +263,13 @@ ANEW M_Object new_M_UGen(const struct Gwion_ *gwion) {
 
 ANN static void assign_channel(const struct Gwion_ *gwion, const UGen u) {
   u->multi = 1;
-  u->compute = gen_compute_multi;
   u->connect.multi->channel = (M_Object*)xmalloc(u->connect.multi->n_chan * SZ_INT);
   for(uint i = u->connect.multi->n_chan + 1; --i;) {
     const uint j = i - 1;
     const M_Object chan = new_M_UGen(gwion);
     ugen_ini(gwion, UGEN(chan), u->connect.multi->n_in > j, u->connect.multi->n_out > j);
     UGEN(chan)->module.ref = u;
-    UGEN(chan)->compute = compute_chan;
+    UGEN(chan)->chan = 1;
     u->connect.multi->channel[j] =  chan;
   }
 }
@@ -117,9 +279,7 @@ ANN void ugen_gen(const struct Gwion_ *gwion, const UGen u, const f_tick tick, v
   u->module.gen.data = data;
   if(trig) {
     u->module.gen.trig = new_UGen(gwion->mp);
-    u->module.gen.trig->compute = compute_mono;
     ugen_ini(gwion, u->module.gen.trig, 1, 1);
-    u->compute = (u->compute == gen_compute_mono ? gen_compute_monotrig : gen_compute_multitrig);
   }
 }
 
@@ -129,6 +289,11 @@ ANN void ugen_ini(const struct Gwion_ *gwion, const UGen u, const uint in, const
     u->connect.net = mp_calloc(gwion->mp, ugen_net);
     vector_init(&u->connect.net->from);
     vector_init(&u->connect.net->to);
+    const uint32_t block = gwion->vm->bbq->si->block;
+    if(block > 1) {
+      u->bin  = (m_float*)xcalloc(block, SZ_FLOAT);
+      u->bout = (m_float*)xcalloc(block, SZ_FLOAT);
+    }
   } else {
     u->connect.multi = mp_calloc(gwion->mp, ugen_multi);
     u->connect.multi->n_in   = in;
@@ -172,6 +337,7 @@ ANN /* static */ void _do_(const f_connect f, const UGen lhs, const UGen rhs) {
     const UGen r = r_multi ? UGEN(rhs->connect.multi->channel[i % r_max]) : rhs;
     f(l, r);
   } while(++i < max);
+  graph_changed();
 }
 
 ANN void ugen_connect(const restrict UGen lhs, const restrict UGen rhs) {
@@ -281,6 +447,10 @@ ANN static void release_mono(MemPool p, const UGen ug) {
   release_to(ug);
   release_from(ug);
   mp_free(p, ugen_net, ug->connect.net);
+  if(ug->bin) {
+    xfree(ug->bin);
+    xfree(ug->bout);
+  }
 }
 
 ANN static void release_multi(const UGen ug, const VM_Shred shred) {
@@ -293,6 +463,7 @@ static DTOR(ugen_dtor) {
   const UGen ug = UGEN(o);
   MemPool p = shred->info->vm->gwion->mp;
   vector_rem2(&shred->info->vm->ugen, (vtype)ug);
+  graph_changed();
   if(!ug->multi)
     release_mono(p, ug);
   else
@@ -342,6 +513,7 @@ struct ugen_importer {
   const f_tick tick;
   const m_str name;
   const uint nchan;
+  const f_block block;
 };
 
 ANN static UGen add_ugen(const Gwi gwi, struct ugen_importer* imp) {
@@ -350,6 +522,7 @@ ANN static UGen add_ugen(const Gwi gwi, struct ugen_importer* imp) {
   const UGen u = UGEN(o);
   ugen_ini(vm->gwion, u, imp->nchan, imp->nchan);
   ugen_gen(vm->gwion, u, imp->tick, (void*)imp->vm, 0);
+  u->module.gen.block = imp->block;
   vector_add(&vm->ugen, (vtype)u);
   gwi_item_ini(gwi, "UGen", imp->name);
   gwi_item_end(gwi, ae_flag_const, obj, o);
@@ -358,11 +531,11 @@ ANN static UGen add_ugen(const Gwi gwi, struct ugen_importer* imp) {
 
 static GWION_IMPORT(global_ugens) {
   const VM* vm = gwi_vm(gwi);
-  struct ugen_importer imp_hole = { vm, compute_mono, "blackhole", 1 };
+  struct ugen_importer imp_hole = { vm, hole_tick, "blackhole", 1, hole_block };
   const UGen hole = add_ugen(gwi, &imp_hole);
-  struct ugen_importer imp_dac = { vm, dac_tick, "dac", vm->bbq->si->out };
+  struct ugen_importer imp_dac = { vm, dac_tick, "dac", vm->bbq->si->out, dac_block };
   const UGen dac = add_ugen(gwi, &imp_dac);
-  struct ugen_importer imp_adc = { vm, adc_tick, "adc", vm->bbq->si->in };
+  struct ugen_importer imp_adc = { vm, adc_tick, "adc", vm->bbq->si->in, adc_block };
   (void)add_ugen(gwi, &imp_adc);
   ugen_connect(dac, hole);
   SET_FLAG(gwi->gwion->type[et_ugen], abstract);
@@ -5,6 +5,7 @@
 #include "vm.h"
 #include "gwion.h"
 #include "arg.h"
+#include "zygote.h"
 
 static void sig(int unused NUSED) {
 #ifdef BUILD_ON_WINDOWS
@@ -37,7 +38,11 @@ int main(int argc, char** argv) {
   signal(SIGINT, sig);
   signal(SIGTERM, sig);
   struct Gwion_ gwion = {};
-  const m_bool ini = gwion_ini(&gwion, &arg);
+  m_bool ini = gwion_ini(&gwion, &arg);
+#ifndef BUILD_ON_WINDOWS
+  if(ini > 0 && arg.zygote)
+    ini = zygote(&gwion, arg.zygote);
+#endif
   arg_release(&arg);
   if(ini > 0)
     gwion_run(&gwion);
@@ -0,0 +1,420 @@
+#include "gwion_util.h"
+#include "gwion_ast.h"
+#include "gwion_env.h"
+#include "vm.h"
+#include "gwion.h"
+#include "object.h"
+#include "traverse.h"
+
+#undef insert_symbol
+
+/* objects declared in a function body that are only used through
+ * their data members, or through methods that keep 'this' to themselves,
+ * can live in the frame. emit picks them up through vflag_stack */
+
+#define STACK_OBJECT_MAX (SZ_INT * 16) // per function, keep frames within the stack slack
+
+typedef struct {
+  Env    env;
+  Symbol this_sym;
+  Symbol spork_sym;
+  Symbol fork_sym;
+  Type   self;  // set while checking code that runs on 'this'
+  m_bool safe;  // cleared when 'this' escapes that code
+  uint   func;  // inside a function body
+  m_uint room;  // frame bytes left for objects
+  struct Vector_ cand; // values marked in the current function
+  struct Vector_ busy; // methods being checked, assumed safe
+  struct Map_ types;   // 1: may live in a frame, 2: may not
+} NoEscape;
+
+ANN static void noescape_exp(NoEscape *a, Exp b);
+ANN static void noescape_stmt(NoEscape *a, Stmt b);
+ANN static void noescape_stmt_list(NoEscape *a, Stmt_List b);
+ANN static void _noescape_ast(NoEscape *a, Ast b);
+
+ANN static inline m_bool tracked(const NoEscape *a, const Exp e) {
+  if(e->exp_type != ae_exp_primary || e->d.prim.prim_type != ae_prim_id)
+    return 0;
+  if(a->self)
+    return e->d.prim.d.var == a->this_sym;
+  const Value v = e->d.prim.value;
+  return v && vflag(v, vflag_stack);
+}
+
+ANN static inline void escape(NoEscape *a, const Exp e) {
+  if(a->self)
+    a->safe = 0;
+  else
+    unset_vflag(e->d.prim.value, vflag_stack);
+}
+
+// closures and sporks may outlive the frame
+ANN static void escape_all(NoEscape *a) {
+  if(a->self) {
+    a->safe = 0;
+    return;
+  }
+  for(m_uint i = 0; i < vector_size(&a->cand); ++i)
+    unset_vflag((Value)vector_at(&a->cand, i), vflag_stack);
+}
+
+ANN static m_bool code_safe(NoEscape *a, const Type self, const Func f) {
+  if(vector_find(&a->busy, (vtype)f) > -1)
+    return 1;
+  vector_add(&a->busy, (vtype)f);
+  const Type self_prev = a->self;
+  const m_bool safe_prev = a->safe;
+  a->self = self;
+  a->safe = 1;
+  noescape_stmt(a, f->def->d.code);
+  const m_bool ret = a->safe;
+  a->self = self_prev;
+  a->safe = safe_prev;
+  vector_pop(&a->busy);
+  return ret;
+}
+
+ANN static m_bool method_safe(NoEscape *a, const Type self, const Exp func) {
+  const Gwion gwion = a->env->gwion;
+  if(is_fptr(gwion, func->type))
+    return 0;
+  const Type t = actual_type(gwion, func->type);
+  if(isa(t, gwion->type[et_function]) < 0)
+    return 0;
+  Func f = t->info->func;
+  if(GET_FLAG(f->def->base, static))
+    return 1;
+  // the object is exactly 'self', so the vtable tells which code runs
+  const Vector vt = &self->nspc->info->vtable;
+  if(vt->ptr && f->vt_index < vector_size(vt))
+    f = (Func)vector_at(vt, f->vt_index);
+  if(vflag(f->value_ref, vflag_builtin) || f->def->base->tmpl || !f->def->d.code)
+    return 0;
+  return code_safe(a, self, f);
+}
+
+ANN static m_bool ctor_safe(NoEscape *a, const Type self, const Ast body) {
+  const Type self_prev = a->self;
+  const m_bool safe_prev = a->safe;
+  a->self = self;
+  a->safe = 1;
+  _noescape_ast(a, body);
+  const m_bool ret = a->safe;
+  a->self = self_prev;
+  a->safe = safe_prev;
+  return ret;
+}
+
+ANN static m_bool _type_ok(NoEscape *a, const Type t) {
+  const Type object = a->env->gwion->type[et_object];
+  if(t->array_depth || tflag(t, tflag_struct) || isa(t, object) < 0)
+    return 0;
+  for(Type p = t; p != object; p = p->info->parent) {
+    if(!tflag(p, tflag_cdef) || tflag(p, tflag_dtor) || GET_FLAG(p, abstract))
+      return 0;
+    if(tflag(p, tflag_ctor) && (!p->info->cdef->body ||
+        !ctor_safe(a, t, p->info->cdef->body)))
+      return 0;
+  }
+  return 1;
+}
+
+ANN static m_bool type_ok(NoEscape *a, const Type t) {
+  const m_uint known = map_get(&a->types, (vtype)t);
+  if(known)
+    return known == 1;
+  const m_bool ok = _type_ok(a, t);
+  map_set(&a->types, (vtype)t, ok ? 1 : 2);
+  return ok;
+}
+
+ANN static void noescape_cand(NoEscape *a, Exp_Decl *b) {
+  if(GET_FLAG(b->td, late) || GET_FLAG(b->td, static) ||
+      GET_FLAG(b->td, global) || type_ref(b->type))
+    return;
+  Var_Decl_List list = b->list;
+  do {
+    const Value v = list->self->value;
+    if(list->self->array || GET_FLAG(v, late) || vflag(v, vflag_member) ||
+        OBJECT_SIZE(v->type) > a->room || !type_ok(a, v->type))
+      continue;
+    a->room -= OBJECT_SIZE(v->type);
+    set_vflag(v, vflag_stack);
+    vector_add(&a->cand, (vtype)v);
+  } while((list = list->next));
+}
+
+ANN static void noescape_array_sub(NoEscape *a, Array_Sub b) {
+  if(b->exp)
+    noescape_exp(a, b->exp);
+}
+
+ANN static void noescape_range(NoEscape *a, Range *b) {
+  if(b->start)
+    noescape_exp(a, b->start);
+  if(b->end)
+    noescape_exp(a, b->end);
+}
+
+ANN static void noescape_prim(NoEscape *a, Exp_Primary *b) {
+  if(b->prim_type == ae_prim_id) {
+    const Exp e = exp_self(b);
+    if(tracked(a, e))
+      escape(a, e);
+  } else if(b->prim_type == ae_prim_hack || b->prim_type == ae_prim_interp)
+    noescape_exp(a, b->d.exp);
+  else if(b->prim_type == ae_prim_array)
+    noescape_array_sub(a, b->d.array);
+  else if(b->prim_type == ae_prim_range)
+    noescape_range(a, b->d.range);
+}
+
+ANN static void noescape_exp_decl(NoEscape *a, Exp_Decl *b) {
+  if(b->td->array)
+    noescape_array_sub(a, b->td->array);
+  Var_Decl_List list = b->list;
+  do if(list->self->array)
+    noescape_array_sub(a, list->self->array);
+  while((list = list->next));
+}
+
+ANN static void noescape_exp_binary(NoEscape *a, Exp_Binary *b) {
+  noescape_exp(a, b->lhs);
+  noescape_exp(a, b->rhs);
+}
+
+ANN static void noescape_exp_unary(NoEscape *a, Exp_Unary *b) {
+  if(b->unary_type == unary_code || b->op == a->spork_sym || b->op == a->fork_sym)
+    escape_all(a);
+  else if(b->unary_type == unary_exp)
+    noescape_exp(a, b->exp);
+}
+
+ANN static void noescape_exp_cast(NoEscape *a, Exp_Cast *b) {
+  noescape_exp(a, b->exp);
+}
+
+ANN static void noescape_exp_post(NoEscape *a, Exp_Postfix *b) {
+  noescape_exp(a, b->exp);
+}
+
+// 'f()' inside a method is 'this.f()'
+ANN static inline m_bool implicit_method(const NoEscape *a, const Exp e) {
+  if(!a->self || e->exp_type != ae_exp_primary || e->d.prim.prim_type != ae_prim_id)
+    return 0;
+  const Value v = e->d.prim.value;
+  return v && vflag(v, vflag_member);
+}
+
+ANN static void noescape_exp_call(NoEscape *a, Exp_Call *b) {
+  const Exp func = b->func;
+  if(func->exp_type == ae_exp_dot && tracked(a, func->d.exp_dot.base)) {
+    const Exp base = func->d.exp_dot.base;
+    const Type self = a->self ?: base->d.prim.value->type;
+    if(b->tmpl || !method_safe(a, self, func))
+      escape(a, base);
+  } else if(implicit_method(a, func)) {
+    if(b->tmpl || !method_safe(a, a->self, func))
+      a->safe = 0;
+  } else
+    noescape_exp(a, func);
+  if(b->args)
+    noescape_exp(a, b->args);
+}
+
+ANN static void noescape_exp_array(NoEscape *a, Exp_Array *b) {
+  noescape_exp(a, b->base);
+  noescape_array_sub(a, b->array);
+}
+
+ANN static void noescape_exp_slice(NoEscape *a, Exp_Slice *b) {
+  noescape_exp(a, b->base);
+  noescape_range(a, b->range);
+}
+
+ANN static void noescape_exp_if(NoEscape *a, Exp_If *b) {
+  noescape_exp(a, b->cond);
+  if(b->if_exp)
+    noescape_exp(a, b->if_exp);
+  noescape_exp(a, b->else_exp);
+}
+
+// data members are fine, anything else hands the object over
+ANN static void noescape_exp_dot(NoEscape *a, Exp_Dot *b) {
+  if(!tracked(a, b->base))
+    noescape_exp(a, b->base);
+  else if(isa(exp_self(b)->type, a->env->gwion->type[et_function]) > 0 ||
+      is_fptr(a->env->gwion, exp_self(b)->type))
+    escape(a, b->base);
+}
+
+ANN static void noescape_exp_lambda(NoEscape *a, Exp_Lambda *b NUSED) {
+  escape_all(a);
+}
+
+ANN static void noescape_exp_td(NoEscape *a NUSED, Type_Decl **b NUSED) {}
+
+DECL_EXP_FUNC(noescape, void, NoEscape*)
+ANN static void noescape_exp(NoEscape *a, Exp b) {
+  noescape_exp_func[b->exp_type](a, &b->d);
+  if(b->next)
+    noescape_exp(a, b->next);
+}
+
+ANN static void noescape_stmt_exp(NoEscape *a, Stmt_Exp b) {
+  if(!b->val)
+    return;
+  if(a->func && !a->self && b->val->exp_type == ae_exp_decl && !b->val->next)
+    noescape_cand(a, &b->val->d.exp_decl);
+  noescape_exp(a, b->val);
+}
+
+ANN static void noescape_stmt_flow(NoEscape *a, Stmt_Flow b) {
+  noescape_exp(a, b->cond);
+  noescape_stmt(a, b->body);
+}
+
+#define noescape_stmt_while noescape_stmt_flow
+#define noescape_stmt_until noescape_stmt_flow
+
+ANN static void noescape_stmt_for(NoEscape *a, Stmt_For b) {
+  noescape_stmt(a, b->c1);
+  if(b->c2)
+    noescape_stmt(a, b->c2);
+  if(b->c3)
+    noescape_exp(a, b->c3);
+  noescape_stmt(a, b->body);
+}
+
+ANN static void noescape_stmt_each(NoEscape *a, Stmt_Each b) {
+  noescape_exp(a, b->exp);
+  noescape_stmt(a, b->body);
+}
+
+ANN static void noescape_stmt_loop(NoEscape *a, Stmt_Loop b) {
+  noescape_exp(a, b->cond);
+  noescape_stmt(a, b->body);
+}
+
+ANN static void noescape_stmt_if(NoEscape *a, Stmt_If b) {
+  noescape_exp(a, b->cond);
+  noescape_stmt(a, b->if_body);
+  if(b->else_body)
+    noescape_stmt(a, b->else_body);
+}
+
+ANN static void noescape_stmt_code(NoEscape *a, Stmt_Code b) {
+  if(b->stmt_list)
+    noescape_stmt_list(a, b->stmt_list);
+}
+
+ANN static void noescape_stmt_varloop(NoEscape *a, Stmt_VarLoop b) {
+  noescape_exp(a, b->exp);
+  noescape_stmt(a, b->body);
+}
+
+ANN static void noescape_stmt_return(NoEscape *a, Stmt_Exp b) {
+  if(b->val)
+    noescape_exp(a, b->val);
+}
+
+ANN static void noescape_stmt_case(NoEscape *a, Stmt_Match b) {
+  noescape_exp(a, b->cond);
+  noescape_stmt_list(a, b->list);
+  if(b->when)
+    noescape_exp(a, b->when);
+}
+
+ANN static void noescape_case_list(NoEscape *a, Stmt_List b) {
+  noescape_stmt_case(a, &b->stmt->d.stmt_match);
+  if(b->next)
+    noescape_case_list(a, b->next);
+}
+
+ANN static void noescape_stmt_match(NoEscape *a, Stmt_Match b) {
+  noescape_exp(a, b->cond);
+  noescape_case_list(a, b->list);
+  if(b->where)
+    noescape_stmt(a, b->where);
+}
+
+ANN static void noescape_stmt_defer(NoEscape *a, Stmt_Defer b) {
+  noescape_stmt(a, b->stmt);
+}
+
+ANN static void noescape_dummy(NoEscape *a NUSED, void *b NUSED) {}
+#define noescape_stmt_jump noescape_dummy
+#define noescape_stmt_pp noescape_dummy
+#define noescape_stmt_break noescape_dummy
+#define noescape_stmt_continue noescape_dummy
+
+DECL_STMT_FUNC(noescape, void, NoEscape*)
+ANN static void noescape_stmt(NoEscape *a, Stmt b) {
+  noescape_stmt_func[b->stmt_type](a, &b->d);
+}
+
+ANN static void noescape_stmt_list(NoEscape *a, Stmt_List b) {
+  noescape_stmt(a, b->stmt);
+  if(b->next)
+    noescape_stmt_list(a, b->next);
+}
+
+// methods are only looked at when called on something we track
+ANN static void noescape_func_def(NoEscape *a, Func_Def b) {
+  if(a->self || !b->d.code || b->base->tmpl || !b->base->func ||
+      vflag(b->base->func->value_ref, vflag_builtin))
+    return;
+  if(a->func) // nested functions may see our locals
+    escape_all(a);
+  const uint func = a->func;
+  const m_uint room = a->room;
+  const m_uint ncand = vector_size(&a->cand);
+  a->func = 1;
+  a->room = STACK_OBJECT_MAX;
+  noescape_stmt(a, b->d.code);
+  a->func = func;
+  a->room = room;
+  while(vector_size(&a->cand) > ncand)
+    vector_pop(&a->cand);
+}
+
+ANN static void noescape_class_def(NoEscape *a, Class_Def b) {
+  if(a->self || tmpl_base(b->base.tmpl) || !b->body)
+    return;
+  const uint func = a->func;
+  a->func = 0;
+  _noescape_ast(a, b->body);
+  a->func = func;
+}
+
+#define noescape_enum_def noescape_dummy
+#define noescape_union_def noescape_dummy
+#define noescape_fptr_def noescape_dummy
+#define noescape_type_def noescape_dummy
+
+DECL_SECTION_FUNC(noescape, void, NoEscape*)
+
+ANN static inline void noescape_section(NoEscape *a, Section *b) {
+  noescape_section_func[b->section_type](a, *(void**)&b->d);
+}
+
+ANN static void _noescape_ast(NoEscape *a, Ast b) {
+  noescape_section(a, b->section);
+  if(b->next)
+    _noescape_ast(a, b->next);
+}
+
+ANN m_bool noescape_ast(const Env env, Ast ast) {
+  SymTable *st = env->gwion->st;
+  NoEscape a = { .env=env, .this_sym=insert_symbol(st, "this"),
+    .spork_sym=insert_symbol(st, "spork"), .fork_sym=insert_symbol(st, "fork") };
+  vector_init(&a.cand);
+  vector_init(&a.busy);
+  map_init(&a.types);
+  _noescape_ast(&a, ast);
+  map_release(&a.types);
+  vector_release(&a.busy);
+  vector_release(&a.cand);
+  return GW_OK;
+}
@@ -144,7 +144,7 @@ ANN static void typedef_fptr(const Env env, const Type_Def tdef, const Type base
   tdef->type->info->func = base->info->func;
   nspc_addref(tdef->type->nspc);
   tdef->type->name = s_name(tdef->xid);
-  tdef->type->info->parent = base;
+  set_parent(tdef->type, base);
   add_type(env, env->curr, tdef->type);
   mk_class(env, tdef->type);
   if(base->info->func->def->base->tmpl)
@@ -184,7 +184,7 @@ ANN static Type enum_type(const Env env, const Enum_Def edef) {
   const Type t = type_copy(env->gwion->mp, env->gwion->type[et_int]);
   const Symbol sym = scan0_sym(env, "enum", edef->pos);
   t->name = edef->xid ? s_name(edef->xid) : s_name(sym);
-  t->info->parent = env->gwion->type[et_int];
+  set_parent(t, env->gwion->type[et_int]);
   const Nspc nspc = GET_FLAG(edef, global) ? env->global_nspc : env->curr;
   t->info->owner = nspc;
   t->info->owner_class = env->class_def;
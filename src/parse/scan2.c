@@ -297,7 +297,7 @@ ANN static Func scan_new_func(const Env env, const Func_Def f, const m_str name)
 ANN static Type func_type(const Env env, const Func func) {
   const Type base = env->gwion->type[!fbflag(func->def->base, fbflag_lambda) ? et_function : et_lambda];
   const Type t = type_copy(env->gwion->mp, base);
-  t->info->parent = base;
+  set_parent(t, base);
   t->name = func->name;
   t->info->owner = env->curr;
   t->info->owner_class = env->class_def;
@@ -61,7 +61,7 @@ static ANN Type scan_func(const Env env, const Type t, const Type_Decl* td) {
   if(base_type)
     return base_type;
   const Type ret = type_copy(env->gwion->mp, t);
-  ret->info->parent = t;
+  set_parent(ret, t);
   ret->name = s_name(sym);
   set_tflag(ret, tflag_ftmpl);
   nspc_add_type_front(t->info->owner, sym, ret);
@@ -8,8 +8,8 @@
 #include "pass.h"
 #include "traverse.h"
 
-static const m_str default_passes_name[] = { "check", "emit" };
-static const compilation_pass default_passes[] = { traverse_ast, emit_ast };
+static const m_str default_passes_name[] = { "check", "noescape", "emit" };
+static const compilation_pass default_passes[] = { traverse_ast, noescape_ast, emit_ast };
 #define NPASS sizeof(default_passes)/sizeof(default_passes[0])
 
 ANN void pass_register(const Gwion gwion, const m_str name, const compilation_pass pass) {
@@ -13,5 +13,6 @@ struct SoundInfo_ *soundinfo_cpy(MemPool p, const struct SoundInfo_ *src) {
   si->in  = src->in;
   si->out = src->out;
   si->sr  = src->sr;
+  si->block = src->block;
   return si;
 }
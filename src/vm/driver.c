@@ -19,6 +19,10 @@ ANN void free_driver(Driver *d, VM *vm) {
     xfree(d->in);
   if(d->out)
     xfree(d->out);
+  if(d->bin)
+    xfree(d->bin);
+  if(d->bout)
+    xfree(d->bout);
   mp_free(vm->gwion->mp, SoundInfo, d->si);
   if(d->driver->del)
     d->driver->del(vm, d);
@@ -29,12 +33,18 @@ ANN void free_driver(Driver *d, VM *vm) {
 ANN void driver_alloc(Driver *d) {
   d->out = (m_float*)xcalloc(d->si->out, SZ_FLOAT);
   d->in  = (m_float*)xcalloc(d->si->in, SZ_FLOAT);
+  if(d->si->block > 1) {
+    d->bout = (m_float*)xcalloc(d->si->block * d->si->out, SZ_FLOAT);
+    d->bin  = (m_float*)xcalloc(d->si->block * d->si->in, SZ_FLOAT);
+  }
 }
 
 static DRVRUN(dummy_run) {
   while(di->is_running) {
     di->run(vm);
     ++di->pos;
+    vm_skip_idle(vm);
+    vm_idle_wait(vm);
   }
 }
 
@@ -0,0 +1,162 @@
+#ifndef BUILD_ON_WINDOWS
+#include <unistd.h>
+#endif
+#include "gwion_util.h"
+#include "gwion_thread.h"
+#include "forkpool.h"
+
+struct ForkWorker_ {
+  THREAD_TYPE thread;
+  THREAD_COND_TYPE wake; // the worker parks on it
+  THREAD_COND_TYPE done; // the joiner waits on it
+  struct ForkPool_ *pool;
+  f_forkpool run;
+  void *data;
+  volatile m_uint *slot;
+};
+
+struct ForkPool_ {
+  MemPool mp;
+  MUTEX_TYPE mutex;
+  struct Vector_ idle;  // parked workers
+  struct Vector_ dead;  // exited workers, not joined yet
+  struct Vector_ gwion; // finished child instances, ready for reuse
+  m_uint instances;     // child instances built because none was ready
+  m_uint max;
+  m_bool done;
+};
+
+ANN static m_uint forkpool_size(void) {
+#ifndef BUILD_ON_WINDOWS
+  const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if(n > 0)
+    return (m_uint)n;
+#endif
+  return 4;
+}
+
+ANN ForkPool new_forkpool(MemPool p, const m_uint max) {
+  const ForkPool pool = mp_calloc(p, ForkPool);
+  pool->mp = p;
+  MUTEX_SETUP(pool->mutex);
+  vector_init(&pool->idle);
+  vector_init(&pool->dead);
+  vector_init(&pool->gwion);
+  pool->max = max ?: forkpool_size();
+  return pool;
+}
+
+ANN static void free_worker(MemPool p, struct ForkWorker_ *w) {
+  THREAD_JOIN(w->thread);
+  THREAD_COND_CLEANUP(w->wake);
+  THREAD_COND_CLEANUP(w->done);
+  mp_free(p, ForkWorker, w);
+}
+
+ANN static void forkpool_reap(MemPool p, const ForkPool pool) {
+  for(m_uint i = 0; i < vector_size(&pool->dead); ++i)
+    free_worker(p, (struct ForkWorker_*)vector_at(&pool->dead, i));
+  vector_clear(&pool->dead);
+}
+
+// every fork has been joined by now, so all workers are parked
+ANN void free_forkpool(MemPool p, ForkPool pool) {
+  MUTEX_LOCK(pool->mutex);
+  pool->done = 1;
+  for(m_uint i = 0; i < vector_size(&pool->idle); ++i)
+    THREAD_COND_SIGNAL(((struct ForkWorker_*)vector_at(&pool->idle, i))->wake);
+  MUTEX_UNLOCK(pool->mutex);
+  for(m_uint i = 0; i < vector_size(&pool->idle); ++i)
+    free_worker(p, (struct ForkWorker_*)vector_at(&pool->idle, i));
+  forkpool_reap(p, pool);
+  vector_release(&pool->idle);
+  vector_release(&pool->dead);
+  vector_release(&pool->gwion);
+  MUTEX_CLEANUP(pool->mutex);
+  mp_free(p, ForkPool, pool);
+}
+
+static THREAD_FUNC(forkpool_worker) {
+  struct ForkWorker_ *w = data;
+  const ForkPool pool = w->pool;
+  MUTEX_LOCK(pool->mutex);
+  while(w->run) {
+    MUTEX_UNLOCK(pool->mutex);
+    w->run(w->data);
+    MUTEX_LOCK(pool->mutex);
+    *w->slot = 0;
+    w->run = NULL;
+    THREAD_COND_SIGNAL(w->done);
+    if(pool->done || vector_size(&pool->idle) >= pool->max)
+      break;
+    vector_add(&pool->idle, (vtype)w);
+    while(!w->run && !pool->done)
+      THREAD_COND_WAIT(w->wake, pool->mutex);
+  }
+  if(vector_find(&pool->idle, (vtype)w) < 0)
+    vector_add(&pool->dead, (vtype)w);
+  MUTEX_UNLOCK(pool->mutex);
+  THREAD_RETURN(0);
+}
+
+// *slot holds the worker until the task is over
+ANN void forkpool_launch(const ForkPool pool, const f_forkpool run, void *data, volatile m_uint *slot) {
+  MUTEX_LOCK(pool->mutex);
+  forkpool_reap(pool->mp, pool);
+  const m_bool spawn = !vector_size(&pool->idle);
+  struct ForkWorker_ *w = !spawn ?
+    (struct ForkWorker_*)vector_pop(&pool->idle) : mp_calloc(pool->mp, ForkWorker);
+  w->run = run;
+  w->data = data;
+  w->slot = slot;
+  *slot = (m_uint)w;
+  if(spawn) {
+    THREAD_COND_SETUP(w->wake);
+    THREAD_COND_SETUP(w->done);
+    w->pool = pool;
+    THREAD_CREATE(w->thread, forkpool_worker, w);
+  } else
+    THREAD_COND_SIGNAL(w->wake);
+  MUTEX_UNLOCK(pool->mutex);
+}
+
+ANN void forkpool_join(const ForkPool pool, volatile m_uint *slot) {
+  MUTEX_LOCK(pool->mutex);
+  struct ForkWorker_ *w;
+  while((w = (struct ForkWorker_*)*slot))
+    THREAD_COND_WAIT(w->done, pool->mutex);
+  MUTEX_UNLOCK(pool->mutex);
+}
+
+ANN struct Gwion_* forkpool_get(const ForkPool pool) {
+  MUTEX_LOCK(pool->mutex);
+  struct Gwion_ *gwion = vector_size(&pool->gwion) ?
+    (struct Gwion_*)vector_pop(&pool->gwion) : NULL;
+  if(!gwion)
+    ++pool->instances; // the caller builds one
+  MUTEX_UNLOCK(pool->mutex);
+  return gwion;
+}
+
+ANN m_bool forkpool_put(const ForkPool pool, struct Gwion_ *gwion) {
+  MUTEX_LOCK(pool->mutex);
+  const m_bool ret = !pool->done && vector_size(&pool->gwion) < pool->max;
+  if(ret)
+    vector_add(&pool->gwion, (vtype)gwion);
+  MUTEX_UNLOCK(pool->mutex);
+  return ret;
+}
+
+ANN m_uint forkpool_instances(const ForkPool pool) {
+  MUTEX_LOCK(pool->mutex);
+  const m_uint n = pool->instances;
+  MUTEX_UNLOCK(pool->mutex);
+  return n;
+}
+
+// workers do not survive fork(2)
+ANN void forkpool_child(const ForkPool pool) {
+  MUTEX_SETUP(pool->mutex);
+  vector_clear(&pool->idle);
+  vector_clear(&pool->dead);
+}
@@ -12,9 +12,168 @@ ANN void shreduler_set_loop(const Shreduler s, const m_bool loop) {
   s->loop = loop > 0;
 }
 
+ANN static inline m_bool tick_before(const struct ShredTick_ *a, const struct ShredTick_ *b) {
+  return a->wake_time < b->wake_time ||
+        (a->wake_time == b->wake_time && a->seq < b->seq);
+}
+
+#define HEAP(v, i) ((struct ShredTick_*)vector_at((v), (i)))
+
+ANN static inline void heap_set(const Vector v, const m_uint i, struct ShredTick_ *tk) {
+  VPTR(v, i) = (vtype)tk;
+  tk->idx = i + 1;
+}
+
+ANN static void heap_up(const Vector v, m_uint i) {
+  struct ShredTick_ *const tk = HEAP(v, i);
+  while(i) {
+    const m_uint parent = (i - 1) / 2;
+    struct ShredTick_ *const p = HEAP(v, parent);
+    if(!tick_before(tk, p))
+      break;
+    heap_set(v, i, p);
+    i = parent;
+  }
+  heap_set(v, i, tk);
+}
+
+ANN static void heap_down(const Vector v, m_uint i) {
+  const m_uint sz = vector_size(v);
+  struct ShredTick_ *const tk = HEAP(v, i);
+  m_uint child;
+  while((child = i * 2 + 1) < sz) {
+    if(child + 1 < sz && tick_before(HEAP(v, child + 1), HEAP(v, child)))
+      ++child;
+    struct ShredTick_ *const c = HEAP(v, child);
+    if(!tick_before(c, tk))
+      break;
+    heap_set(v, i, c);
+    i = child;
+  }
+  heap_set(v, i, tk);
+}
+
+ANN static void heap_rem(const Vector v, struct ShredTick_ *tk) {
+  const m_uint i = tk->idx - 1;
+  struct ShredTick_ *const last = (struct ShredTick_*)vector_pop(v);
+  tk->idx = 0;
+  if(last != tk) {
+    heap_set(v, i, last);
+    heap_down(v, i);
+    heap_up(v, last->idx - 1);
+  }
+}
+
+// xids are handed out in sequence, so masking them spreads well enough
+#define BY_ID(s, xid) ((xid) & ((s)->by_id_cap - 1))
+
+ANN static void by_id_set(const Shreduler s, struct ShredTick_ *tk) {
+  size_t i = BY_ID(s, tk->xid);
+  while(s->by_id[i])
+    i = BY_ID(s, i + 1);
+  s->by_id[i] = tk;
+}
+
+ANN static void by_id_grow(const Shreduler s) {
+  struct ShredTick_ **old = s->by_id;
+  const size_t cap = s->by_id_cap;
+  s->by_id_cap = cap ? cap * 2 : 64;
+  s->by_id = (struct ShredTick_**)xcalloc(s->by_id_cap, sizeof(struct ShredTick_*));
+  for(size_t i = 0; i < cap; ++i) {
+    if(old[i])
+      by_id_set(s, old[i]);
+  }
+  if(old)
+    xfree(old);
+}
+
+// backward shift deletion, no tombstones
+ANN static void by_id_rem(const Shreduler s, const struct ShredTick_ *tk) {
+  size_t i = BY_ID(s, tk->xid);
+  while(s->by_id[i] != tk)
+    i = BY_ID(s, i + 1);
+  size_t j = i;
+  while(1) {
+    j = BY_ID(s, j + 1);
+    struct ShredTick_ *const next = s->by_id[j];
+    if(!next)
+      break;
+    const size_t home = BY_ID(s, next->xid);
+    if((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+      s->by_id[i] = next;
+      i = j;
+    }
+  }
+  s->by_id[i] = NULL;
+}
+
+// callers on other threads hold the lock while they use the result
+ANN VM_Shred shreduler_find(const Shreduler s, const m_uint xid) {
+  VM_Shred ret = NULL;
+  MUTEX_LOCK(s->mutex);
+  if(s->by_id_cap) {
+    size_t i = BY_ID(s, xid);
+    struct ShredTick_ *tk;
+    while((tk = s->by_id[i])) {
+      if(tk->xid == xid) {
+        ret = tk->self;
+        break;
+      }
+      i = BY_ID(s, i + 1);
+    }
+  }
+  MUTEX_UNLOCK(s->mutex);
+  return ret;
+}
+
+ANN void shreduler_release(const Shreduler s) {
+  vector_release(&s->shreds);
+  vector_release(&s->heap);
+  if(s->by_id)
+    xfree(s->by_id);
+}
+
+/* wake a suspended shred without taking its shreduler lock,
+ * the owning VM picks it up in shreduler_get */
+ANN void shreduler_post(const Shreduler s, const VM_Shred shred) {
+  struct ShredTick_ *const tk = shred->tick;
+  if(__atomic_exchange_n(&tk->posted, 1, __ATOMIC_ACQ_REL))
+    return;
+  struct ShredTick_ *head = __atomic_load_n(&s->inbox, __ATOMIC_RELAXED);
+  do tk->next = head;
+  while(!__atomic_compare_exchange_n(&s->inbox, &head, tk, 1,
+      __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+  if(s->idle)
+    shreduler_wake(s);
+}
+
+/* wake 'shred' from a shred running on 'from'.
+ * another VM's thread holds its lock while it runs
+ * and may be waiting on ours, so go through its inbox */
+ANN void shreduler_signal(const Shreduler from, const VM_Shred shred) {
+  const Shreduler s = shred->tick->shreduler;
+  if(s == from)
+    shredule(s, shred, GWION_EPSILON);
+  else
+    shreduler_post(s, shred);
+}
+
+ANN void shreduler_drain(const Shreduler s) {
+  struct ShredTick_ *tk = __atomic_exchange_n(&s->inbox, NULL, __ATOMIC_ACQUIRE);
+  while(tk) {
+    struct ShredTick_ *const next = tk->next;
+    tk->next = NULL;
+    __atomic_store_n(&tk->posted, 0, __ATOMIC_RELEASE);
+    shredule(s, tk->self, GWION_EPSILON);
+    tk = next;
+  }
+}
+
 ANN VM_Shred shreduler_get(const Shreduler s) {
   Driver *const bbq = s->bbq;
-  struct ShredTick_ *const tk = s->list;
+  if(__atomic_load_n(&s->inbox, __ATOMIC_RELAXED))
+    shreduler_drain(s);
+  struct ShredTick_ *const tk = shreduler_front(s);
   if(!tk) {
     if(!vector_size(&s->shreds) && !s->loop)
       bbq->is_running = 0;
@@ -22,9 +181,7 @@ ANN VM_Shred shreduler_get(const Shreduler s) {
   }
   const m_float time = (m_float)bbq->pos + (m_float)GWION_EPSILON;
   if(tk->wake_time <= time) {
-    if((s->list = tk->next))
-      s->list->prev = NULL;
-    tk->next = tk->prev = NULL;
+    heap_rem(&s->heap, tk);
     s->curr = tk;
     return tk->self;
   }
@@ -47,25 +204,32 @@ ANN static inline void shreduler_child(const Vector v) {
 }
 
 ANN static void shreduler_erase(const Shreduler s, struct ShredTick_ *tk) {
+  if(tk->unwait)
+    tk->unwait(tk->self);
   if(tk->parent)
     shreduler_parent(tk->self, &tk->parent->child);
   if(tk->child.ptr)
     shreduler_child(&tk->child);
-  vector_rem2(&s->shreds, (vtype)tk->self);
+  if(!tk->slot)
+    return;
+  const Vector v = &s->shreds;
+  const VM_Shred last = (VM_Shred)vector_pop(v);
+  if(last != tk->self) {
+    VPTR(v, tk->slot - 1) = (vtype)last;
+    last->tick->slot = tk->slot;
+  }
+  tk->slot = 0;
+  by_id_rem(s, tk);
 }
 
 ANN void shreduler_remove(const Shreduler s, const VM_Shred out, const m_bool erase) {
   MUTEX_LOCK(s->mutex);
   struct ShredTick_ *tk = out->tick;
+  tk->resv = 0; // parked or gone, it will queue up again when woken
   if(tk == s->curr)
     s->curr = NULL;
-  else if(tk == s->list)
-    s->list = tk->next;
-  if(tk->prev)
-    tk->prev->next = tk->next;
-  if(tk->next)
-    tk->next->prev = tk->prev;
-  tk->prev = tk->next = NULL;
+  else if(tk->idx)
+    heap_rem(&s->heap, tk);
   if(erase) {
     shreduler_erase(s, tk);
     _release(out->info->me, out);
@@ -73,41 +237,96 @@ ANN void shreduler_remove(const Shreduler s, const VM_Shred out, const m_bool er
   MUTEX_UNLOCK(s->mutex);
 }
 
+/* may be called from another thread,
+ * so take the lock the driver is waiting on */
+ANN void shreduler_wake(const Shreduler s) {
+  MUTEX_LOCK(s->mutex);
+  THREAD_COND_SIGNAL(s->cond);
+  MUTEX_UNLOCK(s->mutex);
+}
+
+/* events and channels reach here from other VMs' threads:
+ * the lock orders the insertion against vm_idle_wait's test */
 ANN void shredule(const Shreduler s, const VM_Shred shred, const m_float wake_time) {
+  MUTEX_LOCK(s->mutex);
   const m_float time = wake_time + (m_float)s->bbq->pos;
   struct ShredTick_ *tk = shred->tick;
   tk->wake_time = time;
-  if(s->list) {
-    struct ShredTick_ *curr = s->list, *prev = NULL;
-    do {
-      if(curr->wake_time > time)
-        break;
-      prev = curr;
-    } while((curr = curr->next));
-    if(!prev) {
-      tk->next = s->list;
-      s->list = (s->list->prev = tk);
-    } else {
-      if((tk->next = prev->next))
-        prev->next->prev = tk;
-      tk->prev = prev;
-      prev->next = tk;
-    }
-  } else
-    s->list = tk;
+  tk->seq = tk->resv ?: ++s->seq;
+  tk->resv = 0;
+  if(!tk->idx) {
+    vector_add(&s->heap, (vtype)tk);
+    heap_up(&s->heap, vector_size(&s->heap) - 1);
+  } else {
+    heap_down(&s->heap, tk->idx - 1);
+    heap_up(&s->heap, tk->idx - 1);
+  }
   if(tk == s->curr)
     s->curr = NULL;
+  if(s->idle)
+    THREAD_COND_SIGNAL(s->cond);
+  MUTEX_UNLOCK(s->mutex);
+}
+
+/* wake many shreds at the same time, as broadcast does:
+ * append them all, then either sift each one up
+ * or rebuild the heap in one pass when they outnumber it */
+ANN void shreduler_wake_all(const Shreduler s, VM_Shred const *shreds, const m_uint n, const m_float wake_time) {
+  MUTEX_LOCK(s->mutex);
+  const m_float time = wake_time + (m_float)s->bbq->pos;
+  for(m_uint i = 0; i < n; ++i) {
+    struct ShredTick_ *const tk = shreds[i]->tick;
+    if(tk->idx)
+      heap_rem(&s->heap, tk);
+  }
+  const m_uint base = vector_size(&s->heap);
+  for(m_uint i = 0; i < n; ++i) {
+    struct ShredTick_ *const tk = shreds[i]->tick;
+    tk->wake_time = time;
+    tk->seq = ++s->seq;
+    vector_add(&s->heap, (vtype)tk);
+    tk->idx = vector_size(&s->heap);
+    if(tk == s->curr)
+      s->curr = NULL;
+  }
+  const m_uint size = vector_size(&s->heap);
+  if(n > base) {
+    for(m_uint i = size / 2; i--;)
+      heap_down(&s->heap, i);
+  } else {
+    for(m_uint i = base; i < size; ++i)
+      heap_up(&s->heap, i);
+  }
+  if(s->idle)
+    THREAD_COND_SIGNAL(s->cond);
+  MUTEX_UNLOCK(s->mutex);
+}
+
+// put a popped shred back, keeping its place among the ones due with it
+ANN void shreduler_requeue(const Shreduler s, const VM_Shred shred) {
+  struct ShredTick_ *tk = shred->tick;
+  vector_add(&s->heap, (vtype)tk);
+  heap_up(&s->heap, vector_size(&s->heap) - 1);
 }
 
 ANN void shreduler_ini(const Shreduler s, const VM_Shred shred) {
-  shred->tick = mp_calloc(shred->info->mp, ShredTick);
+  if(shred->tick) // recycled by vm_shred_alloc
+    memset(shred->tick, 0, sizeof(struct ShredTick_));
+  else
+    shred->tick = mp_calloc(shred->info->mp, ShredTick);
   shred->tick->self = shred;
   shred->tick->shreduler = s;
 }
 
 ANN void shreduler_add(const Shreduler s, const VM_Shred shred) {
+  MUTEX_LOCK(s->mutex);
   shreduler_ini(s, shred);
   shred->tick->xid = ++s->shred_ids;
   vector_add(&s->shreds, (vtype)shred);
+  shred->tick->slot = vector_size(&s->shreds);
+  if((vector_size(&s->shreds) + 1) * 2 > s->by_id_cap)
+    by_id_grow(s);
+  by_id_set(s, shred->tick);
   shredule(s, shred, GWION_EPSILON);
+  MUTEX_UNLOCK(s->mutex);
 }
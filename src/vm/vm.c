@@ -1,4 +1,5 @@
 #include <time.h>
+#include <math.h>
 #include "gwion_util.h"
 #include "gwion_ast.h"
 #include "gwion_env.h"
@@ -13,6 +14,8 @@
 #include "import.h"
 #include "gack.h"
 #include "array.h"
+#include "vmprof.h"
+#include "forkpool.h"
 
 static inline uint64_t splitmix64_stateless(uint64_t index) {
   uint64_t z = (index + UINT64_C(0x9E3779B97F4A7C15));
@@ -41,20 +44,26 @@ uint32_t gw_rand(uint32_t s[2]) {
 }
 
 void vm_remove(const VM* vm, const m_uint index) {
-  const Vector v = (Vector)&vm->shreduler->shreds;
-  LOOP_OPTIM
-  for(m_uint i = vector_size(v) + 1; --i;) {
-    const VM_Shred sh = (VM_Shred)vector_at(v, i - 1);
-    if(sh && sh->tick->xid == index)
-       Except(sh, "MsgRemove");
-  }
+  MUTEX_LOCK(vm->shreduler->mutex);
+  const VM_Shred sh = shreduler_find(vm->shreduler, index);
+  if(sh)
+    Except(sh, "MsgRemove");
+  MUTEX_UNLOCK(vm->shreduler->mutex);
 }
 
+ANN static void free_vmpar(MemPool, struct VMPar_*);
+
 ANN void free_vm(VM* vm) {
-  vector_release(&vm->shreduler->shreds);
+  if(vm->par)
+    free_vmpar(vm->gwion->mp, vm->par);
+  vm_shred_pool_release(vm);
+  MUTEX_CLEANUP(vm->pool_mutex);
+  shreduler_release(vm->shreduler);
   vector_release(&vm->ugen);
+  vector_release(&vm->ugen_sched);
   if(vm->bbq)
     free_driver(vm->bbq, vm);
+  THREAD_COND_CLEANUP(vm->shreduler->cond);
   MUTEX_CLEANUP(vm->shreduler->mutex);
   mp_free(vm->gwion->mp, Shreduler, vm->shreduler);
   mp_free(vm->gwion->mp, VM, vm);
@@ -91,24 +100,6 @@ ANN m_bool vm_running(VM const *vm) {
   return vm->shreduler->bbq->is_running = vm_running(vm->parent);
 }
 
-__attribute__((hot))
-ANN static inline void vm_ugen_init(const VM* vm) {
-  const Vector v = (Vector)&vm->ugen;
-  LOOP_OPTIM
-  for(m_uint i = vector_size(v) + 1; --i;) {
-    const UGen u = (UGen)vector_at(v, i - 1);
-    u->done = 0;
-    if(u->multi) {
-      struct ugen_multi_* m = u->connect.multi;
-      LOOP_OPTIM
-      for(m_uint j = m->n_chan + 1; --j;)
-        UGEN(m->channel[j - 1])->done = 0;
-    }
-  }
-  const UGen hole = (UGen)vector_at(v, 0);
-  hole->compute(hole);
-}
-
 #ifdef DEBUG_STACK
 #define VM_INFO                                                              \
   gw_err("shred[%" UINT_F "] mem[%" INT_F"] reg[%" INT_F"]\n", \
@@ -118,8 +109,9 @@ ANN static inline void vm_ugen_init(const VM* vm) {
 #define VM_INFO
 #endif
 
+// also true when mem left the segment, shred_stack_grow sorts it out
 ANN static inline m_bool overflow_(const m_bit* mem, const VM_Shred c) {
-  return mem > (((m_bit*)c + sizeof(struct VM_Shred_) + SIZEOF_REG) + (SIZEOF_MEM) - (MEM_STEP*16));
+  return (m_uint)(mem - c->stack) > c->stack_size - (MEM_STEP*16);
 }
 
 ANN /*static inline */VM_Shred init_spork_shred(const VM_Shred shred, const VM_Code code) {
@@ -129,12 +121,13 @@ ANN /*static inline */VM_Shred init_spork_shred(const VM_Shred shred, const VM_C
   if(!shred->tick->child.ptr)
     vector_init(&shred->tick->child);
   vector_add(&shred->tick->child, (vtype)sh);
-  vector_add(&shred->gc, (vtype)sh->info->me);
+  shred_gc_add(shred, sh->info->me);
   return sh;
 }
 
 ANN M_Object new_fork(const VM_Shred, const VM_Code code, const Type);
 ANN static VM_Shred init_fork_shred(const VM_Shred shred, const VM_Code code, const Type t, const m_uint retsz) {
+  fork_retire(shred);
   const M_Object o = new_fork(shred, code, t);
   VM* vm = shred->info->vm;
   if(!vm->gwion->data->child.ptr)
@@ -148,7 +141,7 @@ ANN static VM_Shred init_fork_shred(const VM_Shred shred, const VM_Code code, co
 
 #define ADVANCE() byte += BYTECODE_SZ;
 
-#define SDISPATCH() goto *dispatch[*(m_bit*)byte];
+#define SDISPATCH() goto *table[*(m_bit*)byte];
 #define IDISPATCH() { VM_INFO; SDISPATCH(); }
 
 #define SET_BYTE(pc)	(byte = bytecode + (pc) * BYTECODE_SZ)
@@ -184,6 +177,14 @@ DISPATCH()
 
 #define INT_LOGICAL(op) LOGICAL(m_int, SZ_INT, 0, op)
 
+#define MEM_IMM_OP(op) \
+  *(m_int*)reg = *(m_int*)(mem + (m_int)VAL) op (m_int)VAL2; \
+  reg += SZ_INT; \
+  DISPATCH()
+
+#define INT_BRANCH(op) \
+  BRANCH_DISPATCH(!(*(m_int*)(reg - SZ_INT * 2) op *(m_int*)(reg - SZ_INT)), SZ_INT * 2)
+
 #define FLOAT_LOGICAL(op) LOGICAL(m_float, SZ_FLOAT * 2 - SZ_INT, \
   SZ_FLOAT - SZ_INT, op)
 
@@ -271,16 +272,66 @@ _Pragma(STRINGIFY(COMPILER diagnostic ignored UNINITIALIZED)
 #define FVAL (*(m_float*)(byte + VMSZ))
 #define VAL2 (*(m_uint*)(byte + SZ_INT + SZ_INT))
 
-#define BRANCH_DISPATCH(check) \
-  if(check) SET_BYTE(VAL);\
-  else ADVANCE(); \
+// jumps and calls draw from the shred's budget
+#define BUDGET() if(!--budget) goto overbudget;
+
+// the operands are popped once the budget allows the jump,
+// so a helper thread can bail out and rerun the branch as is
+#define BRANCH_DISPATCH(check, sz) \
+  if(check) { BUDGET() reg -= sz; SET_BYTE(VAL); }\
+  else { reg -= sz; ADVANCE(); } \
   IDISPATCH();
 
+// DotFuncCache keeps the vtable index and the reg offset in the spare bytes
+// VAL and VAL2 hold the cached type and code
+#define DOTFUNC_INDEX (*(uint16_t*)(byte + 5))
+#define DOTFUNC_OFFSET (*(int8_t*)(byte + 7) * SZ_INT)
+
+// monomorphic: the first receiver wins, other types use the vtable
+static inline void dotfunc_fill(m_bit *const byte, const Type t, const VM_Code code) {
+  VM_Code expect = NULL;
+  if(code && __atomic_compare_exchange_n((VM_Code*)(byte + SZ_INT*2), &expect, code,
+        0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    __atomic_store_n((Type*)(byte + VMSZ), t, __ATOMIC_RELEASE);
+}
+
 #define VM_OUT shred->code = code; shred->reg = reg; shred->mem = mem; shred->pc = PC;
 
+/* --jobs: shreds due on the same sample are handed to helper threads.
+ * they only run instructions that touch their own stack,
+ * anything else sends them back to the serial loop, at the same time
+ * and in the same order they would have had */
+enum par_state { par_yield, par_bail, par_eoc };
+
+struct ParTask_ {
+  VM_Shred shred;
+  m_float delay;
+  enum par_state state;
+};
+
+struct VMPar_ {
+  const VM *vm;
+  struct ParTask_ *task;
+  m_uint cap;
+  m_uint n;
+  volatile m_uint next; // idle threads take the next due shred
+  m_uint jobs;
+  volatile m_uint *slot;
+};
+
+#define PAR_MIN 4 // less than that per thread is not worth a wake up
+
+ANN static inline VM_Shred par_next(struct VMPar_ *const par, struct ParTask_ **task) {
+  const m_uint i = __atomic_fetch_add(&par->next, 1, __ATOMIC_RELAXED);
+  if(i >= par->n)
+    return NULL;
+  *task = par->task + i;
+  return par->task[i].shred;
+}
+
 __attribute__ ((hot))
 CC_OPTIM(-O2)
-ANN void vm_run(const VM* vm) { // lgtm [cpp/use-of-goto]
+ANN static void _vm_run(const VM* vm, struct VMPar_ *const par) { // lgtm [cpp/use-of-goto]
   static const void* dispatch[] = {
     &&regsetimm,
     &&regpushimm, &&regpushfloat, &&regpushother, &&regpushaddr,
@@ -324,25 +375,101 @@ ANN void vm_run(const VM* vm) { // lgtm [cpp/use-of-goto]
     &&sporkini, &&forkini, &&sporkfunc, &&sporkmemberfptr, &&sporkexp, &&sporkend,
     &&brancheqint, &&branchneint, &&brancheqfloat, &&branchnefloat, &&unroll,
     &&arrayappend, &&autounrollinit, &&autoloop, &&arraytop, &&arrayaccess, &&arrayget, &&arrayaddr, &&arrayvalid,
-    &&newobj, &&addref, &&addrefaddr, &&structaddref, &&structaddrefaddr, &&objassign, &&assign, &&remref,
+    &&newobj, &&stackobj, &&addref, &&addrefaddr, &&structaddref, &&structaddrefaddr, &&objassign, &&assign, &&remref,
     &&except, &&allocmemberaddr, &&dotmember, &&dotfloat, &&dotother, &&dotaddr,
     &&unioncheck, &&unionint, &&unionfloat, &&unionother, &&unionaddr,
     &&staticint, &&staticfloat, &&staticother,
     &&upvalueint, &&upvaluefloat, &&upvalueother, &&upvalueaddr,
-    &&dotfunc,
+    &&dotfunc, &&dotfunccache,
     &&gcini, &&gcadd, &&gcend,
-    &&gacktype, &&gackend, &&gack, &&noop, &&eoc, &&unroll2, &&other, &&regpushimm
+    &&gacktype, &&gackend, &&gack,
+    &&regpushmemimm, &&memimmintadd, &&memimmintsub, &&memimmintmul, &&memdotmember,
+    &&inteqbranch, &&intnebranch, &&intgtbranch, &&intgebranch, &&intltbranch, &&intlebranch,
+    &&noop, &&eoc, &&unroll2, &&other, &&regpushimm
   };
+#ifdef GWION_VMPROF
+  static const void* prof_dispatch[] = { [0 ... eDotTmplVal] = &&prof };
+#endif
+PRAGMA_PUSH()
+_Pragma(STRINGIFY(COMPILER diagnostic ignored "-Woverride-init"))
+  static const void* par_dispatch[] = {
+    [0 ... eDotTmplVal] = &&parbail,
+    [eRegSetImm] = &&regsetimm,
+    [eRegPushImm] = &&regpushimm, [eRegPushImm2] = &&regpushfloat,
+    [eRegPushMem] = &&regpushmem, [eRegPushMem2] = &&regpushmemfloat,
+    [eRegPushMem3] = &&regpushmemother, [eRegPushMem4] = &&regpushmemaddr,
+    [eRegPushNow] = &&pushnow,
+    [eReg2Reg] = &&regtoreg, [eReg2RegOther] = &&regtoregother, [eReg2RegAddr] = &&regtoregaddr,
+    [eMemSetImm] = &&memsetimm,
+    [eFuncReturn] = &&funcreturn, [eGoto] = &&_goto,
+    [eAllocWord] = &&allocint, [eAllocWord2] = &&allocfloat, [eAllocWord3] = &&allocother,
+    [eint_plus] = &&intplus, [eint_minus] = &&intminus, [eint_mul] = &&intmul,
+    [eint_eq] = &&inteq, [eint_neq] = &&intne, [eint_and] = &&intand, [eint_or] = &&intor,
+    [eint_gt] = &&intgt, [eint_ge] = &&intge, [eint_lt] = &&intlt, [eint_le] = &&intle,
+    [eint_sl] = &&intsl, [eint_sr] = &&intsr, [eint_sand] = &&intsand, [eint_sor] = &&intsor,
+    [eint_xor] = &&intxor, [eint_negate] = &&intnegate, [eIntNot] = &&intnot, [eint_cmp] = &&intcmp,
+    [eint_r_assign] = &&intrassign,
+    [eint_r_plus] = &&intradd, [eint_r_minus] = &&intrsub, [eint_r_mul] = &&intrmul,
+    [eint_r_sl] = &&intrsl, [eint_r_sr] = &&intrsr, [eint_r_sand] = &&intrsand,
+    [eint_r_sor] = &&intrsor, [eint_r_sxor] = &&intrxor,
+    [eint_pre_inc] = &&preinc, [eint_pre_dec] = &&predec,
+    [eint_post_inc] = &&postinc, [eint_post_dec] = &&postdec,
+    [eFloatPlus] = &&floatadd, [eFloatMinus] = &&floatsub,
+    [eFloatTimes] = &&floatmul, [eFloatDivide] = &&floatdiv,
+    [efloat_and] = &&floatand, [efloat_or] = &&floator,
+    [efloat_eq] = &&floateq, [efloat_neq] = &&floatne,
+    [efloat_gt] = &&floatgt, [efloat_ge] = &&floatge,
+    [efloat_lt] = &&floatlt, [efloat_le] = &&floatle,
+    [efloat_negate] = &&floatneg, [efloat_not] = &&floatnot,
+    [efloat_r_assign] = &&floatrassign, [efloat_r_plus] = &&floatradd,
+    [efloat_r_minus] = &&floatrsub, [efloat_r_mul] = &&floatrmul, [efloat_r_div] = &&floatrdiv,
+    [eint_float_plus] = &&ifadd, [eint_float_minus] = &&ifsub,
+    [eint_float_mul] = &&ifmul, [eint_float_div] = &&ifdiv,
+    [eint_float_and] = &&ifand, [eint_float_or] = &&ifor,
+    [eint_float_eq] = &&ifeq, [eint_float_neq] = &&ifne,
+    [eint_float_gt] = &&ifgt, [eint_float_ge] = &&ifge,
+    [eint_float_lt] = &&iflt, [eint_float_le] = &&ifle,
+    [eint_float_r_assign] = &&ifrassign, [eint_float_r_plus] = &&ifradd,
+    [eint_float_r_minus] = &&ifrsub, [eint_float_r_mul] = &&ifrmul, [eint_float_r_div] = &&ifrdiv,
+    [efloat_int_plus] = &&fiadd, [efloat_int_minus] = &&fisub,
+    [efloat_int_mul] = &&fimul, [efloat_int_div] = &&fidiv,
+    [efloat_int_and] = &&fiand, [efloat_int_or] = &&fior,
+    [efloat_int_eq] = &&fieq, [efloat_int_neq] = &&fine,
+    [efloat_int_gt] = &&figt, [efloat_int_ge] = &&fige,
+    [efloat_int_lt] = &&filt, [efloat_int_le] = &&file,
+    [efloat_int_r_assign] = &&firassign, [efloat_int_r_plus] = &&firadd,
+    [efloat_int_r_minus] = &&firsub, [efloat_int_r_mul] = &&firmul, [efloat_int_r_div] = &&firdiv,
+    [eCastI2F] = &&itof, [eCastF2I] = &&ftoi,
+    [eTime_Advance] = &&partimeadv,
+    [eRegMove] = &&regmove, [eReg2Mem] = &&regtomem, [eReg2Mem4] = &&regtomemother,
+    [eBranchEqInt] = &&brancheqint, [eBranchNeqInt] = &&branchneint,
+    [eBranchEqFloat] = &&brancheqfloat, [eBranchNeqFloat] = &&branchnefloat,
+    [eRegPushMemImm] = &&regpushmemimm,
+    [eMemImmIntPlus] = &&memimmintadd, [eMemImmIntMinus] = &&memimmintsub, [eMemImmIntMul] = &&memimmintmul,
+    [eIntEqBranch] = &&inteqbranch, [eIntNeqBranch] = &&intnebranch,
+    [eIntGtBranch] = &&intgtbranch, [eIntGeBranch] = &&intgebranch,
+    [eIntLtBranch] = &&intltbranch, [eIntLeBranch] = &&intlebranch,
+    [eNoOp] = &&noop, [eEOC] = &&pareoc,
+  };
+PRAGMA_POP()
+  const void* const* const table = par ? par_dispatch :
+#ifdef GWION_VMPROF
+    vm->prof ? prof_dispatch :
+#endif
+    dispatch;
   const Shreduler s = vm->shreduler;
+  struct ParTask_ *task = NULL;
   register VM_Shred shred;
   register m_bit next;
 
-  while((shred = shreduler_get(s))) {
+  while((shred = par ? par_next(par, &task) : shreduler_get(s))) {
     register VM_Code code = shred->code;
     register m_bit* bytecode = code->bytecode;
     register m_bit* byte = bytecode + shred->pc * BYTECODE_SZ;
     register m_bit* reg = shred->reg;
     register m_bit* mem = shred->mem;
+    register m_uint budget = shred->budget ?: vm->budget; // 0 wraps around, that is no limit
+    shred->budget = 0;
     register union {
       M_Object obj;
       VM_Code code;
@@ -350,7 +477,8 @@ ANN void vm_run(const VM* vm) { // lgtm [cpp/use-of-goto]
 PRAGMA_PUSH()
     register VM_Shred child;
 PRAGMA_POP()
-  MUTEX_LOCK(s->mutex);
+  if(!par) // the serial loop holds it for the whole batch
+    MUTEX_LOCK(s->mutex);
   do {
     SDISPATCH();
 regsetimm:
@@ -460,6 +588,7 @@ funcreturn:
   PC_DISPATCH(pc);
 }
 _goto:
+  BUDGET()
   PC_DISPATCH(VAL);
 allocint:
   *(m_uint*)reg = *(m_uint*)(mem+VAL) = 0;
@@ -642,7 +771,8 @@ regtomemother:
   memcpy(mem+VAL, reg, VAL2);
   DISPATCH()
 overflow:
-  if(overflow_(mem + VAL2, shred)) {
+  if(overflow_(mem + VAL2, shred) &&
+     !(mem = shred_stack_grow(shred, mem, VAL2, next == eFuncUsrEnd))) {
     shred->pc = PC;
     exception(shred, "StackOverflow");
     continue;
@@ -651,6 +781,7 @@ PRAGMA_PUSH()
   goto *dispatch[next];
 PRAGMA_POP()
 funcusrend:
+  BUDGET()
 PRAGMA_PUSH()
   byte = bytecode = (code = a.code)->bytecode;
 PRAGMA_POP()
@@ -663,7 +794,10 @@ funcmemberend:
     ((f_mfun)a.code->native_func)((*(M_Object*)mem), reg, shred);
     reg += val;
     shred->mem = (mem -= val2);
-    if(!s->curr)break;
+    if(!s->curr) {
+      shred->reg = reg; // the call suspended the shred
+      break;
+    }
   }
   PC_DISPATCH(shred->pc)
 sporkini:
@@ -700,17 +834,13 @@ PRAGMA_PUSH()
 PRAGMA_POP()
   DISPATCH()
 brancheqint:
-  reg -= SZ_INT;
-  BRANCH_DISPATCH(!*(m_uint*)reg);
+  BRANCH_DISPATCH(!*(m_uint*)(reg - SZ_INT), SZ_INT);
 branchneint:
-  reg -= SZ_INT;
-  BRANCH_DISPATCH(*(m_uint*)reg);
+  BRANCH_DISPATCH(*(m_uint*)(reg - SZ_INT), SZ_INT);
 brancheqfloat:
-  reg -= SZ_FLOAT;
-  BRANCH_DISPATCH(!*(m_float*)reg);
+  BRANCH_DISPATCH(!*(m_float*)(reg - SZ_FLOAT), SZ_FLOAT);
 branchnefloat:
-  reg -= SZ_FLOAT;
-  BRANCH_DISPATCH(*(m_float*)reg);
+  BRANCH_DISPATCH(*(m_float*)(reg - SZ_FLOAT), SZ_FLOAT);
 unroll:
 {
   const m_uint n = *(m_uint*)(mem + VAL - SZ_INT);
@@ -772,6 +902,10 @@ newobj:
   *(M_Object*)reg = new_object(vm->gwion->mp, NULL, (Type)VAL2);
   reg += SZ_INT;
   DISPATCH()
+stackobj:
+  *(M_Object*)reg = stack_object(shred, mem + VAL, (Type)VAL2);
+  reg += SZ_INT;
+  DISPATCH()
 addref:
   {
     const M_Object o = *(M_Object*)(reg+(m_int)VAL);
@@ -915,8 +1049,20 @@ upvalueaddr:
   reg += SZ_INT;
   DISPATCH()
 dotfunc:
-  *(VM_Code*)(reg+(m_uint)VAL2) = ((Func)(*(M_Object*)(reg-SZ_INT))->vtable.ptr[OFFSET + VAL])->code;
+  *(VM_Code*)(reg+(m_uint)VAL2) = ((Func)VTABLE(*(M_Object*)(reg-SZ_INT))[OFFSET + VAL])->code;
   DISPATCH()
+dotfunccache:
+{
+  const M_Object o = *(M_Object*)(reg-SZ_INT);
+  if(__atomic_load_n((Type*)(byte + VMSZ), __ATOMIC_ACQUIRE) == o->type)
+    a.code = *(VM_Code*)(byte + SZ_INT*2);
+  else {
+    a.code = ((Func)VTABLE(o)[OFFSET + DOTFUNC_INDEX])->code;
+    dotfunc_fill(byte, o->type, a.code);
+  }
+  *(VM_Code*)(reg + DOTFUNC_OFFSET) = a.code;
+  DISPATCH()
+}
 gcini:
   vector_add(&shred->gc, 0);
   DISPATCH();
@@ -926,8 +1072,10 @@ gcadd:
 gcend:
 {
   M_Object o;
-  while((o = (M_Object)vector_pop(&shred->gc)))
-    _release(o, shred);
+  while((o = (M_Object)vector_pop(&shred->gc))) {
+    if(o != (M_Object)GC_DEAD)
+      _release(o, shred);
+  }
 }
   DISPATCH()
 gacktype:
@@ -952,6 +1100,29 @@ gack:
   VM_OUT
   gack(shred, VAL);
   goto in;
+regpushmemimm:
+  *(m_uint*)reg = *(m_uint*)(mem + (m_int)VAL);
+  *(m_uint*)(reg + SZ_INT) = VAL2;
+  reg += SZ_INT * 2;
+  DISPATCH();
+memimmintadd: MEM_IMM_OP(+)
+memimmintsub: MEM_IMM_OP(-)
+memimmintmul: MEM_IMM_OP(*)
+memdotmember:
+  *(m_uint*)reg = *(m_uint*)((*(M_Object*)(mem + (m_int)VAL))->data + VAL2);
+  reg += SZ_INT;
+  DISPATCH()
+inteqbranch: INT_BRANCH(==)
+intnebranch: INT_BRANCH(!=)
+intgtbranch: INT_BRANCH(>)
+intgebranch: INT_BRANCH(>=)
+intltbranch: INT_BRANCH(<)
+intlebranch: INT_BRANCH(<=)
+#ifdef GWION_VMPROF
+prof:
+  vmprof_tick(vm->prof, code, byte);
+  goto *dispatch[*(m_bit*)byte];
+#endif
 noop:
   DISPATCH();
 other:
@@ -968,24 +1139,215 @@ in:
 eoc:
   VM_OUT
   vm_shred_exit(shred);
+  continue;
+overbudget:
+  if(par) {
+    budget = 1; // the serial loop reruns the jump and reports it
+    goto parbail;
+  }
+  VM_OUT
+  exception(shred, "BudgetExceeded");
+  continue;
+partimeadv:
+  reg -= SZ_FLOAT;
+  task->delay = *(m_float*)(reg-SZ_FLOAT);
+  task->state = par_yield;
+  *(m_float*)(reg-SZ_FLOAT) += vm->bbq->pos;
+  VM_OUT
+  break;
+parbail:
+  VM_OUT
+  shred->pc = (byte - bytecode) / BYTECODE_SZ; // run this one again
+  shred->budget = budget; // what is left carries over
+  task->state = par_bail;
+  break;
+pareoc:
+  VM_OUT
+  task->state = par_eoc;
+  break;
     } while(s->curr);
-  MUTEX_UNLOCK(s->mutex);
+  if(!par)
+    MUTEX_UNLOCK(s->mutex);
+  }
+}
+
+static void vm_par_worker(void *data) {
+  struct VMPar_ *const par = (struct VMPar_*)data;
+  _vm_run(par->vm, par);
+}
+
+ANN static void vm_run_par(const VM *vm) {
+  const Shreduler s = vm->shreduler;
+  struct VMPar_ *const par = vm->par;
+  const ForkPool pool = vm->gwion->data->forkpool;
+  VM_Shred shred;
+  MUTEX_LOCK(s->mutex);
+  par->n = 0;
+  while((shred = shreduler_get(s))) {
+    if(par->n == par->cap) {
+      par->cap = par->cap ? par->cap * 2 : 32;
+      par->task = (struct ParTask_*)xrealloc(par->task, par->cap * sizeof(struct ParTask_));
+    }
+    par->task[par->n++] = (struct ParTask_){ .shred=shred, .state=par_bail };
+    // yields are known out of order, and bailed shreds finish later on:
+    // take their seq now so that equal wake times keep the due order
+    shred->tick->resv = ++s->seq;
+  }
+  s->curr = NULL;
+  m_uint n = par->n / PAR_MIN; // this thread takes a share too
+  if(n && --n > par->jobs)
+    n = par->jobs;
+  if(n) {
+    par->next = 0;
+    for(m_uint i = 0; i < n; ++i)
+      forkpool_launch(pool, vm_par_worker, par, par->slot + i);
+    _vm_run(vm, par);
+    for(m_uint i = 0; i < n; ++i)
+      forkpool_join(pool, par->slot + i);
+  }
+  // back to the shreduler in due order, so reruns stay deterministic
+  for(m_uint i = 0; i < par->n; ++i) {
+    const struct ParTask_ *task = par->task + i;
+    if(task->state == par_yield)
+      shredule(s, task->shred, task->delay);
+    else if(task->state == par_bail)
+      shreduler_requeue(s, task->shred);
+    else
+      vm_shred_exit(task->shred);
   }
+  MUTEX_UNLOCK(s->mutex);
+}
+
+ANN void vm_set_jobs(VM *vm, const m_uint jobs) {
+  const MemPool p = vm->gwion->mp;
+  if(vm->par)
+    free_vmpar(p, vm->par);
+  vm->par = mp_calloc(p, VMPar);
+  vm->par->vm = vm;
+  vm->par->jobs = jobs;
+  vm->par->slot = (volatile m_uint*)xcalloc(jobs, sizeof(m_uint));
+}
+
+ANN static void free_vmpar(MemPool p, struct VMPar_ *par) {
+  if(par->task)
+    xfree(par->task);
+  xfree((m_uint*)par->slot);
+  mp_free(p, VMPar, par);
+}
+
+ANN void vm_run(const VM* vm) {
+  if(vm->par)
+    vm_run_par(vm);
+  _vm_run(vm, NULL);
+#ifdef GWION_VMPROF
+  if(vm->prof)
+    vmprof_stop(vm->prof);
+#endif
 }
 
 static void vm_run_audio(const VM *vm) {
   vm_run(vm);
-  vm_ugen_init(vm);
+  ugen_compute((VM*)vm);
+}
+
+/* number of frames that can be rendered before a shred is due */
+ANN static inline uint32_t block_len(const VM *vm) {
+  const Driver *di = vm->bbq;
+  const struct ShredTick_ *tk = shreduler_front(vm->shreduler);
+  uint32_t len = di->si->block;
+  if(tk) {
+    const m_float next = ceil(tk->wake_time - (m_float)di->pos - (m_float)GWION_EPSILON);
+    if(next < len)
+      len = next > 1 ? (uint32_t)next : 1;
+  }
+  return len;
+}
+
+/* block mode: shreds still run on the exact sample they are due,
+ * but the UGen graph renders up to si->block frames at once.
+ * input frames are captured as they come, so adc is one block late.
+ * a feedback path inside the graph reads what its source rendered
+ * in the previous block, so it is delayed by a whole block, not a sample */
+ANN void vm_run_block(const VM *vm) {
+  Driver *const di = vm->bbq;
+  const uint8_t n_in = di->si->in, n_out = di->si->out;
+  if(di->bidx == di->blen) {
+    vm_run(vm);
+    const uint32_t prev = di->blen;
+    di->blen = block_len(vm);
+    di->bidx = 0;
+    // fewer frames were captured than adc will read: hold the last one
+    for(uint32_t i = prev; prev && i < di->blen; ++i)
+      memcpy(di->bin + i * n_in, di->bin + (prev - 1) * n_in, n_in * SZ_FLOAT);
+    ugen_compute_block((VM*)vm, di->blen);
+  }
+  memcpy(di->bin + di->bidx * n_in, di->in, n_in * SZ_FLOAT);
+  memcpy(di->out, di->bout + di->bidx * n_out, n_out * SZ_FLOAT);
+  ++di->bidx;
+}
+
+/* offline drivers call this after each sample:
+ * when the graph is idle, jump straight to the next due shred */
+ANN void vm_skip_idle(const VM *vm) {
+  Driver *const di = vm->bbq;
+  if(di->bidx != di->blen)
+    return;
+  MUTEX_LOCK(vm->shreduler->mutex);
+  shreduler_drain(vm->shreduler);
+  const struct ShredTick_ *tk = shreduler_front(vm->shreduler);
+  if(tk && ugen_idle((VM*)vm)) {
+    const m_float next = ceil(tk->wake_time - (m_float)GWION_EPSILON);
+    if(next > (m_float)di->pos)
+      di->pos = (uint64_t)next;
+  }
+  MUTEX_UNLOCK(vm->shreduler->mutex);
+}
+
+/* nothing is due and the graph is silent:
+ * sleep until another thread hands us a shred */
+ANN void vm_idle_wait(const VM *vm) {
+  Driver *const di = vm->bbq;
+  const Shreduler s = vm->shreduler;
+  if(di->bidx != di->blen)
+    return;
+  MUTEX_LOCK(s->mutex);
+  if(ugen_idle((VM*)vm)) {
+    s->idle = 1;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while(di->is_running && !vector_size(&s->heap) && !s->inbox &&
+         (s->loop || vector_size(&s->shreds)))
+      THREAD_COND_WAIT(s->cond, s->mutex);
+    s->idle = 0;
+  }
+  MUTEX_UNLOCK(s->mutex);
+}
+
+/* make a finished child VM ready for another fork */
+ANN void vm_reset(VM *vm) {
+  const Shreduler s = vm->shreduler;
+  s->curr = NULL;
+  s->shred_ids = 0;
+  s->seq = 0;
+  s->idle = 0;
+  __atomic_store_n(&s->inbox, NULL, __ATOMIC_RELAXED); // shreds of the last fork
+  vm->bbq->pos = 0;
+  vm->bbq->is_running = 1;
 }
 
 VM* new_vm(MemPool p, const m_bool audio) {
   VM* vm = (VM*)mp_calloc(p, VM);
   vector_init(&vm->ugen);
+  vector_init(&vm->ugen_sched);
+  for(m_uint i = 0; i < SHRED_POOL; ++i)
+    vector_init(&vm->shred_pool[i]);
+  MUTEX_SETUP(vm->pool_mutex);
   vm->bbq = new_driver(p);
   vm->bbq->run = audio ? vm_run_audio : vm_run;
   vm->shreduler  = (Shreduler)mp_calloc(p, Shreduler);
   vector_init(&vm->shreduler->shreds);
+  vector_init(&vm->shreduler->heap);
   MUTEX_SETUP(vm->shreduler->mutex);
+  THREAD_COND_SETUP(vm->shreduler->cond);
   vm->shreduler->bbq = vm->bbq;
 #ifndef __AFL_COMPILER
   gw_seed(vm->rand, (uint64_t)time(NULL));
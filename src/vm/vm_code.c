@@ -9,6 +9,7 @@
 #include "array.h"
 #include "operator.h"
 #include "import.h"
+#include "vmprof.h"
 
 ANN void free_code_instr(const Vector v, const Gwion gwion) {
   for(m_uint i = vector_size(v) + 1; --i;) {
@@ -22,6 +23,10 @@ ANN void free_code_instr(const Vector v, const Gwion gwion) {
 }
 
 ANN void free_vmcode(VM_Code a, Gwion gwion) {
+#ifdef GWION_VMPROF
+  if(gwion->vm->prof)
+    vmprof_forget(gwion->vm->prof, a);
+#endif
   if(a->memoize)
     memoize_end(gwion->mp, a->memoize);
   if(!a->builtin) {
@@ -39,7 +44,154 @@ ANN void free_vmcode(VM_Code a, Gwion gwion) {
 static inline uint isgoto(const unsigned opcode) {
   return opcode == eGoto ||
       opcode == eBranchEqInt || opcode == eBranchNeqInt ||
-      opcode == eBranchEqFloat || opcode == eBranchNeqFloat;
+      opcode == eBranchEqFloat || opcode == eBranchNeqFloat ||
+      opcode == eArrayTop || opcode == eUnionCheck ||
+      (opcode >= eIntEqBranch && opcode <= eIntLeBranch);
+}
+
+#define FUSE_MAX 3
+
+// the fused instruction keeps the first instruction's m_val
+// and takes its other operand from the second one
+ANN static void fuse_val2(const Instr a, const Instr b) { a->m_val2 = b->m_val; }
+ANN static void fuse_val(const Instr a, const Instr b) { a->m_val = b->m_val; }
+
+static const struct Fusion_ {
+  const char *name;
+  const m_bit seq[FUSE_MAX];
+  const m_bit len;
+  const m_bit opcode;
+  void (*fuse)(const Instr, const Instr);
+} fusion[] = {
+  { "mem+imm+int_plus",  { eRegPushMem, eRegPushImm, eint_plus },  3, eMemImmIntPlus,  fuse_val2 },
+  { "mem+imm+int_minus", { eRegPushMem, eRegPushImm, eint_minus }, 3, eMemImmIntMinus, fuse_val2 },
+  { "mem+imm+int_mul",   { eRegPushMem, eRegPushImm, eint_mul },   3, eMemImmIntMul,   fuse_val2 },
+  { "mem+imm",           { eRegPushMem, eRegPushImm },             2, eRegPushMemImm,  fuse_val2 },
+  { "mem+dotmember",     { eRegPushMem, eDotMember },              2, eMemDotMember,   fuse_val2 },
+  { "int_eq+branch",     { eint_eq,  eBranchEqInt },               2, eIntEqBranch,    fuse_val },
+  { "int_neq+branch",    { eint_neq, eBranchEqInt },               2, eIntNeqBranch,   fuse_val },
+  { "int_gt+branch",     { eint_gt,  eBranchEqInt },               2, eIntGtBranch,    fuse_val },
+  { "int_ge+branch",     { eint_ge,  eBranchEqInt },               2, eIntGeBranch,    fuse_val },
+  { "int_lt+branch",     { eint_lt,  eBranchEqInt },               2, eIntLtBranch,    fuse_val },
+  { "int_le+branch",     { eint_le,  eBranchEqInt },               2, eIntLeBranch,    fuse_val },
+};
+
+#define NFUSION (sizeof(fusion) / sizeof(struct Fusion_))
+
+ANN static m_bool fuse_match(const Vector v, const m_bit *target,
+      const m_uint i, const struct Fusion_ *f) {
+  if(i + f->len > vector_size(v))
+    return GW_ERROR;
+  for(m_uint j = 0; j < f->len; ++j) {
+    const Instr instr = (Instr)vector_at(v, i + j);
+    if(instr->opcode != f->seq[j] || (j && target[i + j]))
+      return GW_ERROR;
+  }
+  return GW_OK;
+}
+
+// how far an instruction moves reg, for the few that can sit
+// between a GcAdd and the addref that consumes the same object
+// anything that rewrites a slot in place (DotMember4...) stops the search
+static m_int elide_move(const Instr instr) {
+  switch(instr->opcode) {
+    case eRegPushImm:
+    case eRegPushMem:
+    case eRegPushMem4:
+    case eAllocWord:
+      return SZ_INT;
+    case eRegPushMem2:
+    case eAllocWord2:
+      return SZ_FLOAT;
+    case eMemSetImm:
+    case eNoOp:
+      return 0;
+  }
+  return -1;
+}
+
+// a fresh object registered for the shred's gc and then addref'd
+// (assigned or passed on) hands its reference over: drop both
+ANN static m_uint elide(const VM_Code code, const m_bit *target) {
+  const Vector v = code->instr;
+  const m_uint sz = vector_size(v);
+  m_uint count = 0;
+  for(m_uint i = 0; i < sz; ++i) {
+    const Instr gc = (Instr)vector_at(v, i);
+    if(gc->opcode != eGcAdd || gc->m_val != (m_uint)-SZ_INT)
+      continue;
+    m_int move = 0;
+    for(m_uint j = i + 1; j < sz && !target[j]; ++j) {
+      const Instr instr = (Instr)vector_at(v, j);
+      if(instr->opcode == eRegAddRef) {
+        if((m_int)instr->m_val == -SZ_INT - move) {
+          gc->opcode = instr->opcode = eNoOp;
+          count += 2;
+        }
+        break;
+      }
+      const m_int n = elide_move(instr);
+      if(n < 0)
+        break;
+      move += n;
+    }
+  }
+  return count;
+}
+
+// rewrite common sequences into a single instruction
+// the instructions they replace become NoOps, removed with the others
+// refcount pairs are elided first, see elide
+// code that unrolls or memoizes keeps raw pcs around, leave it alone
+ANN static void fuse(MemPool p, const VM_Code code) {
+  const Vector v = code->instr;
+  const m_uint sz = vector_size(v);
+  for(m_uint i = 0; i < sz; ++i) {
+    const Instr instr = (Instr)vector_at(v, i);
+    if(instr->opcode == eUnroll || instr->execute == MemoizeIni)
+      return;
+  }
+  m_bit *const target = (m_bit*)_mp_calloc(p, sz + 1);
+  for(m_uint i = 0; i < sz; ++i) {
+    const Instr instr = (Instr)vector_at(v, i);
+    if(isgoto(instr->opcode) && instr->m_val < sz)
+      target[instr->m_val] = 1;
+  }
+  code->elided = elide(code, target);
+  for(m_uint i = 0; i < sz; ++i) {
+    for(m_uint n = 0; n < NFUSION; ++n) {
+      const struct Fusion_ *f = &fusion[n];
+      if(fuse_match(v, target, i, f) < 0)
+        continue;
+      const Instr instr = (Instr)vector_at(v, i);
+      f->fuse(instr, (Instr)vector_at(v, i + 1));
+      instr->opcode = f->opcode;
+      for(m_uint j = 1; j < f->len; ++j)
+        ((Instr)vector_at(v, i + j))->opcode = eNoOp;
+      code->fused += f->len - 1;
+      i += f->len - 1;
+      break;
+    }
+  }
+  _mp_free(p, sz + 1, target);
+}
+
+// the index and offset go in bytes 5 to 7, between the pc and VAL
+// that gap only exists with 8 byte words
+#define DOTFUNC_FITS (SZ_INT >= 8 && SZ_FLOAT <= SZ_INT)
+
+// see DotFuncCache in vm_run
+// what does not fit keeps the plain DotFunc
+ANN static void dotfunc_cache(m_bit *const data, const Instr instr) {
+  const m_int offset = (m_int)instr->m_val2;
+  if(!DOTFUNC_FITS || instr->m_val > UINT16_MAX || offset % SZ_INT ||
+     offset / SZ_INT < INT8_MIN || offset / SZ_INT > INT8_MAX)
+    return;
+  *(m_bit*)data = eDotFuncCache;
+  *(uint16_t*)(data + 5) = (uint16_t)instr->m_val;
+  *(int8_t*)(data + 7) = (int8_t)(offset / SZ_INT);
+  *(m_uint*)(data + SZ_INT) = 0;
+  *(m_uint*)(data + SZ_INT*2) = 0;
 }
 
 static inline void setpc(const m_bit *data, const m_uint i) {
@@ -50,6 +202,7 @@ ANN static m_bit* tobytecode(MemPool p, const VM_Code code) {
    const Vector v = code->instr;
   const m_uint sz = vector_size(v);
   m_bit *ptr = _mp_malloc(p, sz * BYTECODE_SZ);
+  fuse(p, code);
   struct Vector_ nop;
   vector_init(&nop);
   for(m_uint i= 0; i < sz; ++i) {
@@ -98,6 +251,9 @@ ANN static m_bit* tobytecode(MemPool p, const VM_Code code) {
       if(instr->opcode == eGoto && instr->m_val  == i+1) {
         instr->opcode = eNoOp;
         vector_add(&nop, i);
+      } else if(instr->opcode == eDotFunc) {
+        memcpy(data, instr, BYTECODE_SZ);
+        dotfunc_cache(data, instr);
       } else if(instr->opcode != eNoOp)
         memcpy(data, instr, BYTECODE_SZ);
       else
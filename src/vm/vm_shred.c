@@ -5,12 +5,26 @@
 #include "gwion.h"
 #include "object.h"
 
-struct Stack_ {
-  VM_Shred shred;
-  char c[SIZEOF_REG];
-  char d[SIZEOF_MEM];
+/* stacks start small and chain segments when a call runs out of room,
+ * up to the SIZEOF_MEM every shred used to get upfront */
+#define SHRED_MEM_MIN 1024
+#define STACK_SLACK (MEM_STEP*16) // left for native calls, see overflow_
+#define FRAME_HEADER (SZ_INT*4)   // written by SetCode before a user frame
+
+struct ShredStack_ {
+  struct ShredStack_ *next;
+  size_t size;
+  m_bit data[];
 };
 
+#define SHRED_SIZE(memsz) (sizeof(struct VM_Shred_) + SIZEOF_REG + (memsz))
+
+ANN static inline size_t stack_size(const size_t need, size_t sz) {
+  while(sz < need)
+    sz <<= 1;
+  return sz < SIZEOF_MEM ? sz : SIZEOF_MEM;
+}
+
 static inline struct ShredInfo_ *new_shredinfo(MemPool p, const m_str name) {
   struct ShredInfo_ *info = mp_calloc(p, ShredInfo);
   info->mp = p;
@@ -18,7 +32,7 @@ static inline struct ShredInfo_ *new_shredinfo(MemPool p, const m_str name) {
   return info;
 }
 
-static inline void free_shredinfo(MemPool mp, struct ShredInfo_ *info) {
+static inline void shredinfo_clear(MemPool mp, struct ShredInfo_ *info) {
   free_mstr(mp, info->name);
   if(info->args) {
     const Vector v = info->args;
@@ -26,28 +40,179 @@ static inline void free_shredinfo(MemPool mp, struct ShredInfo_ *info) {
     for(m_uint i = vector_size(v) + 1; --i;)
       xfree((void*)vector_at(v, i - 1));
     free_vector(mp, v);
+    info->args = NULL;
   }
-  mp_free(mp, ShredInfo, info);
 }
 
-VM_Shred new_vm_shred(MemPool p, VM_Code c) {
-  const VM_Shred shred = mp_calloc(p, Stack);
+VM_Shred new_vm_shred_sized(MemPool p, VM_Code c, const size_t depth) {
+  const size_t memsz = stack_size(depth + FRAME_HEADER + STACK_SLACK, SHRED_MEM_MIN);
+  const VM_Shred shred = (VM_Shred)_mp_calloc(p, SHRED_SIZE(memsz));
   shred->code = c;
   shred->reg  = (m_bit*)shred + sizeof(struct VM_Shred_);
-  shred->base = shred->mem = shred->reg + SIZEOF_REG;
+  shred->base = shred->mem = shred->stack = shred->reg + SIZEOF_REG;
+  shred->stack_size = memsz;
   shred->info = new_shredinfo(p, c->name);
   shred->info->orig = c;
+  shred->info->memsz = memsz;
   vector_init(&shred->gc);
+  vector_init(&shred->frame);
   return shred;
 }
 
-void free_vm_shred(VM_Shred shred) {
-  for(m_uint i = vector_size(&shred->gc) + 1; --i;)
-    release((M_Object)vector_at(&shred->gc, i - 1), shred);
-  vector_release(&shred->gc);
-  vmcode_remref(shred->info->orig, shred->info->vm->gwion);
+VM_Shred new_vm_shred(MemPool p, VM_Code c) {
+  return new_vm_shred_sized(p, c, c->stack_depth);
+}
+
+#define SHRED_POOL_MAX 32 // exited shreds kept per size class
+
+ANN static inline m_uint pool_class(const size_t memsz) {
+  m_uint i = 0;
+  while(((size_t)SHRED_MEM_MIN << i) < memsz)
+    ++i;
+  return i;
+}
+
+/* sporks reuse exited shreds of the same stack size.
+ * the shred and its info are reset as new_vm_shred_sized would leave them, except for
+ *   gc and frame: emptied by free_vm_shred, their storage is kept
+ *   tick: cleared by shreduler_ini
+ *   info->mp, info->memsz: fixed for the size class
+ *   info->stack: extra segments, only written once a call moves in
+ * of the stack only the first frame is zeroed: reg and deeper frames
+ * are always written before being read */
+VM_Shred vm_shred_alloc(const VM *vm, const VM_Code c, const size_t depth) {
+  const size_t memsz = stack_size(depth + FRAME_HEADER + STACK_SLACK, SHRED_MEM_MIN);
+  const m_uint i = pool_class(memsz);
+  if(i >= SHRED_POOL)
+    return new_vm_shred_sized(vm->gwion->mp, c, depth);
+  MUTEX_LOCK(((VM*)vm)->pool_mutex);
+  const VM_Shred shred = (VM_Shred)vector_pop((Vector)&vm->shred_pool[i]);
+  MUTEX_UNLOCK(((VM*)vm)->pool_mutex);
+  if(!shred)
+    return new_vm_shred_sized(vm->gwion->mp, c, depth);
+  struct ShredInfo_ *const info = shred->info;
+  const struct ShredInfo_ keep = *info;
+  memset(info, 0, sizeof(struct ShredInfo_));
+  info->mp = keep.mp;
+  info->memsz = keep.memsz;
+  info->stack = keep.stack;
+  info->name = mstrdup(info->mp, c->name);
+  info->orig = c;
+  const struct VM_Shred_ old = *shred;
+  memset(shred, 0, sizeof(struct VM_Shred_));
+  shred->gc = old.gc;
+  shred->frame = old.frame;
+  shred->tick = old.tick;
+  shred->info = info;
+  shred->code = c;
+  shred->reg  = (m_bit*)shred + sizeof(struct VM_Shred_);
+  shred->base = shred->mem = shred->stack = shred->reg + SIZEOF_REG;
+  shred->stack_size = memsz;
+  memset(shred->mem - SZ_INT, 0, SZ_INT + depth + FRAME_HEADER);
+  return shred;
+}
+
+ANN static void shred_free(const VM_Shred shred) {
   const MemPool mp = shred->info->mp;
+  vector_release(&shred->gc);
+  vector_release(&shred->frame);
   mp_free(mp, ShredTick, shred->tick);
-  free_shredinfo(mp, shred->info);
-  mp_free(mp, Stack, shred);
+  struct ShredStack_ *seg = shred->info->stack;
+  while(seg) {
+    struct ShredStack_ *const next = seg->next;
+    _mp_free(mp, sizeof(struct ShredStack_) + seg->size, seg);
+    seg = next;
+  }
+  const size_t memsz = shred->info->memsz;
+  mp_free(mp, ShredInfo, shred->info);
+  _mp_free(mp, SHRED_SIZE(memsz), shred);
+}
+
+ANN static m_bool shred_pool_put(const VM_Shred shred) {
+  VM *const vm = shred->info->vm;
+  const m_uint i = pool_class(shred->info->memsz);
+  if(!shred->tick || i >= SHRED_POOL)
+    return 0;
+  MUTEX_LOCK(vm->pool_mutex);
+  const m_bool ret = vector_size(&vm->shred_pool[i]) < SHRED_POOL_MAX;
+  if(ret)
+    vector_add(&vm->shred_pool[i], (vtype)shred);
+  MUTEX_UNLOCK(vm->pool_mutex);
+  return ret;
+}
+
+ANN void vm_shred_pool_release(VM *vm) {
+  for(m_uint i = 0; i < SHRED_POOL; ++i) {
+    VM_Shred shred;
+    while((shred = (VM_Shred)vector_pop(&vm->shred_pool[i])))
+      shred_free(shred);
+    vector_release(&vm->shred_pool[i]);
+  }
+}
+
+ANN static size_t stack_total(const struct ShredInfo_ *info) {
+  size_t total = info->memsz;
+  for(const struct ShredStack_ *seg = info->stack; seg; seg = seg->next)
+    total += seg->size;
+  return total;
+}
+
+/* mem is a new frame that is past the segment overflow_ looked at.
+ * it may just be another segment, otherwise a user frame
+ * is copied at the start of the next one, a native frame only gets the slack */
+m_bit* shred_stack_grow(const VM_Shred shred, m_bit *mem, const m_uint extent, const m_bool movable) {
+  struct ShredInfo_ *const info = shred->info;
+  m_bit *const frame = movable ? mem - FRAME_HEADER : mem;
+  m_bit *begin = (m_bit*)shred + sizeof(struct VM_Shred_) + SIZEOF_REG;
+  size_t size = info->memsz;
+  struct ShredStack_ **next = &info->stack;
+  while((m_uint)(frame - begin) > size) {
+    if(!*next)
+      return NULL;
+    begin = (*next)->data;
+    size = (*next)->size;
+    next = &(*next)->next;
+  }
+  if(mem + extent <= begin + size - (movable ? STACK_SLACK : 0)) {
+    shred->stack = begin;
+    shred->stack_size = size;
+    return mem;
+  }
+  if(!movable)
+    return NULL;
+  const m_uint depth = *(m_uint*)(mem - SZ_INT);
+  const size_t need = FRAME_HEADER + (depth > extent ? depth : extent) + STACK_SLACK;
+  struct ShredStack_ *seg = *next;
+  if(!seg || seg->size < need) {
+    const size_t sz = stack_size(need, size * 2);
+    if(sz < need || stack_total(info) + sz > SIZEOF_MEM)
+      return NULL;
+    struct ShredStack_ *const grown = (struct ShredStack_*)_mp_calloc(info->mp, sizeof(struct ShredStack_) + sz);
+    grown->size = sz;
+    grown->next = seg;
+    *next = seg = grown;
+  }
+  const size_t avail = (size_t)(begin + size - frame);
+  const size_t len = FRAME_HEADER + depth;
+  memcpy(seg->data, frame, len < avail ? len : avail);
+  m_bit *const moved = seg->data + FRAME_HEADER;
+  *(m_uint*)seg->data += (m_uint)(moved - mem); // FuncReturn takes it back to the caller
+  shred->stack = seg->data;
+  shred->stack_size = seg->size;
+  return moved;
+}
+
+void free_vm_shred(VM_Shred shred) {
+  // left over when an exception cut the frames short
+  while(vector_size(&shred->frame))
+    _release((M_Object)vector_pop(&shred->frame), shred);
+  while(vector_size(&shred->gc)) {
+    const M_Object o = (M_Object)vector_pop(&shred->gc);
+    if(o != (M_Object)GC_DEAD)
+      release(o, shred);
+  }
+  vmcode_remref(shred->info->orig, shred->info->vm->gwion);
+  shredinfo_clear(shred->info->mp, shred->info);
+  if(!shred_pool_put(shred))
+    shred_free(shred);
 }
@@ -0,0 +1,222 @@
+#ifdef GWION_VMPROF
+#ifndef BUILD_ON_WINDOWS
+#include <dlfcn.h>
+#endif
+#include <inttypes.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define prof_now() __rdtsc()
+#else
+#include <time.h>
+static inline uint64_t prof_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+#endif
+#define OPCODE_NAME
+#include "gwion_util.h"
+#include "gwion_ast.h"
+#include "gwion_env.h"
+#include "vm.h"
+#include "instr.h"
+#include "vmprof.h"
+
+#define NOPCODE (eDotTmplVal + 1)
+
+struct ProfCount_ {
+  m_uint count;
+  uint64_t cycles;
+};
+
+// outlives its VM_Code so the report can name it
+struct ProfCode_ {
+  m_str name;
+  m_uint elided;
+  m_uint fused;
+  struct ProfCount_ op[NOPCODE];
+  struct Map_ native; // f_instr => struct ProfCount_*
+};
+
+struct VMProf_ {
+  struct Map_ live;    // VM_Code => struct ProfCode_*
+  struct Vector_ code; // every struct ProfCode_
+  VM_Code last_code;
+  struct ProfCode_ *curr;
+  struct ProfCount_ *last;
+  uint64_t stamp;
+  MemPool mp;
+  enum vmprof_mode mode;
+};
+
+ANN VMProf new_vmprof(MemPool p, const enum vmprof_mode mode) {
+  const VMProf prof = (VMProf)xcalloc(1, sizeof(struct VMProf_));
+  map_init(&prof->live);
+  vector_init(&prof->code);
+  prof->mp = p;
+  prof->mode = mode;
+  return prof;
+}
+
+ANN void free_vmprof(MemPool p, VMProf prof) {
+  for(m_uint i = 0; i < vector_size(&prof->code); ++i) {
+    struct ProfCode_ *const pc = (struct ProfCode_*)vector_at(&prof->code, i);
+    for(m_uint j = 0; j < map_size(&pc->native); ++j)
+      xfree((struct ProfCount_*)VVAL(&pc->native, j));
+    map_release(&pc->native);
+    free_mstr(p, pc->name);
+    xfree(pc);
+  }
+  vector_release(&prof->code);
+  map_release(&prof->live);
+  xfree(prof);
+}
+
+ANN static struct ProfCode_* prof_code(const VMProf prof, const VM_Code code) {
+  struct ProfCode_ *pc = (struct ProfCode_*)map_get(&prof->live, (vtype)code);
+  if(pc)
+    return pc;
+  pc = (struct ProfCode_*)xcalloc(1, sizeof(struct ProfCode_));
+  pc->name = mstrdup(prof->mp, code->name);
+  pc->elided = code->elided;
+  pc->fused = code->fused;
+  map_init(&pc->native);
+  vector_add(&prof->code, (vtype)pc);
+  map_set(&prof->live, (vtype)code, (vtype)pc);
+  return pc;
+}
+
+ANN static struct ProfCount_* prof_native(struct ProfCode_ *const pc, const f_instr f) {
+  struct ProfCount_ *count = (struct ProfCount_*)map_get(&pc->native, (vtype)f);
+  if(count)
+    return count;
+  count = (struct ProfCount_*)xcalloc(1, sizeof(struct ProfCount_));
+  map_set(&pc->native, (vtype)f, (vtype)count);
+  return count;
+}
+
+// cycles go to the previous instruction, the profiler's own time is left out
+ANN void vmprof_tick(const VMProf prof, const VM_Code code, const m_bit *byte) {
+  if(prof->mode == vmprof_cycles && prof->last)
+    prof->last->cycles += prof_now() - prof->stamp;
+  if(code != prof->last_code) {
+    prof->curr = prof_code(prof, code);
+    prof->last_code = code;
+  }
+  const m_bit op = *byte;
+  struct ProfCount_ *const count = op != eOP_MAX ? &prof->curr->op[op] :
+    prof_native(prof->curr, *(f_instr*)(byte + SZ_INT*2));
+  ++count->count;
+  prof->last = count;
+  if(prof->mode == vmprof_cycles)
+    prof->stamp = prof_now();
+}
+
+ANN void vmprof_stop(const VMProf prof) {
+  if(prof->mode == vmprof_cycles && prof->last)
+    prof->last->cycles += prof_now() - prof->stamp;
+  prof->last = NULL;
+}
+
+// the address may be reused by a later code
+ANN void vmprof_forget(const VMProf prof, const VM_Code code) {
+  if(map_get(&prof->live, (vtype)code))
+    map_set(&prof->live, (vtype)code, 0);
+  if(prof->last_code == code)
+    prof->last_code = NULL;
+}
+
+struct ProfRow_ {
+  m_str code;
+  const char *name;
+  f_instr native;
+  m_uint count;
+  uint64_t cycles;
+};
+
+static int row_cmp(const void *a, const void *b) {
+  const struct ProfRow_ *ra = (const struct ProfRow_*)a,
+                        *rb = (const struct ProfRow_*)b;
+  if(ra->cycles != rb->cycles)
+    return ra->cycles < rb->cycles ? 1 : -1;
+  if(ra->count != rb->count)
+    return ra->count < rb->count ? 1 : -1;
+  return 0;
+}
+
+ANN static void row_print(const struct ProfRow_ *row, const enum vmprof_mode mode) {
+  const char *name = row->name;
+  char buf[32];
+  if(!name) {
+#ifndef BUILD_ON_WINDOWS
+    Dl_info info;
+    if(dladdr((void*)row->native, &info) && info.dli_sname)
+      name = info.dli_sname;
+    else
+#endif
+    {
+      snprintf(buf, sizeof(buf), "%p", (void*)row->native);
+      name = buf;
+    }
+  }
+  if(mode == vmprof_cycles)
+    gw_err("%12" UINT_F " %16" PRIu64 "  %-24s %s\n", row->count, row->cycles, name, row->code);
+  else
+    gw_err("%12" UINT_F "  %-24s %s\n", row->count, name, row->code);
+}
+
+ANN static m_uint prof_rows(const VMProf prof, struct ProfRow_ *rows) {
+  m_uint n = 0;
+  for(m_uint i = 0; i < vector_size(&prof->code); ++i) {
+    const struct ProfCode_ *pc = (struct ProfCode_*)vector_at(&prof->code, i);
+    for(m_uint j = 0; j < NOPCODE; ++j) {
+      if(pc->op[j].count)
+        rows[n++] = (struct ProfRow_){ .code=pc->name, .name=opcode_name[j],
+          .count=pc->op[j].count, .cycles=pc->op[j].cycles };
+    }
+    for(m_uint j = 0; j < map_size(&pc->native); ++j) {
+      const struct ProfCount_ *count = (struct ProfCount_*)VVAL(&pc->native, j);
+      rows[n++] = (struct ProfRow_){ .code=pc->name, .native=(f_instr)VKEY(&pc->native, j),
+        .count=count->count, .cycles=count->cycles };
+    }
+  }
+  return n;
+}
+
+// what the peephole passes took out, per code
+ANN static void prof_saved(const VMProf prof, const m_bool fused) {
+  m_uint total = 0;
+  for(m_uint i = 0; i < vector_size(&prof->code); ++i) {
+    const struct ProfCode_ *pc = (struct ProfCode_*)vector_at(&prof->code, i);
+    const m_uint n = fused ? pc->fused : pc->elided;
+    if(!n)
+      continue;
+    if(!total)
+      gw_err("\n%12s  %s\n", fused ? "fused" : "elided", "code");
+    gw_err("%12" UINT_F "  %s\n", n, pc->name);
+    total += n;
+  }
+  if(total)
+    gw_err("%12" UINT_F "  %s instructions saved\n", total, fused ? "fused" : "refcount");
+}
+
+ANN void vmprof_report(const VMProf prof) {
+  m_uint sz = 0;
+  for(m_uint i = 0; i < vector_size(&prof->code); ++i) {
+    const struct ProfCode_ *pc = (struct ProfCode_*)vector_at(&prof->code, i);
+    sz += NOPCODE + map_size(&pc->native);
+  }
+  struct ProfRow_ *rows = (struct ProfRow_*)xmalloc((sz + 1) * sizeof(struct ProfRow_));
+  const m_uint n = prof_rows(prof, rows);
+  qsort(rows, n, sizeof(struct ProfRow_), row_cmp);
+  if(prof->mode == vmprof_cycles)
+    gw_err("%12s %16s  %-24s %s\n", "count", "cycles", "instruction", "code");
+  else
+    gw_err("%12s  %-24s %s\n", "count", "instruction", "code");
+  for(m_uint i = 0; i < n; ++i)
+    row_print(rows + i, prof->mode);
+  xfree(rows);
+  prof_saved(prof, 0);
+  prof_saved(prof, 1);
+}
+#endif
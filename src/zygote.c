@@ -0,0 +1,81 @@
+#ifndef BUILD_ON_WINDOWS
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "gwion_util.h"
+#include "gwion_ast.h"
+#include "gwion_env.h"
+#include "vm.h"
+#include "gwion.h"
+#include "compile.h"
+#include "zygote.h"
+#include "forkpool.h"
+
+#define ZYGOTE_REQUEST 4096
+
+ANN static int zygote_socket(const char *path) {
+  struct sockaddr_un addr = { .sun_family=AF_UNIX };
+  if(strlen(path) >= sizeof(addr.sun_path)) {
+    gw_err(_("zygote path too long: '%s'\n"), path);
+    return -1;
+  }
+  strcpy(addr.sun_path, path);
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(fd < 0)
+    return -1;
+  unlink(path);
+  if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+    gw_err(_("can't listen on '%s'\n"), path);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// a request is one line of files, with their arguments, as on the command line
+ANN static void zygote_child(const struct Gwion_ *gwion, const int fd) {
+  char buf[ZYGOTE_REQUEST];
+  ssize_t len = 0, n;
+  while(len < ZYGOTE_REQUEST - 1 && (n = read(fd, buf + len, ZYGOTE_REQUEST - 1 - len)) > 0) {
+    len += n;
+    if(memchr(buf + len - n, '\n', n))
+      break;
+  }
+  buf[len > 0 ? len : 0] = '\0';
+  dup2(fd, STDOUT_FILENO);
+  dup2(fd, STDERR_FILENO);
+  close(fd);
+  m_str line = buf, file;
+  while((file = strsep(&line, " \t\r\n"))) {
+    if(*file)
+      compile_filename((struct Gwion_*)gwion, file);
+  }
+}
+
+// keep an initialized process around and fork it for each request
+// the child returns and runs like a normal instance
+ANN m_bool zygote(const struct Gwion_ *gwion, const char *path) {
+  const int sock = zygote_socket(path);
+  if(sock < 0)
+    return GW_ERROR;
+  signal(SIGCHLD, SIG_IGN);
+  int fd;
+  while((fd = accept(sock, NULL, NULL)) >= 0) {
+    const pid_t pid = fork();
+    if(!pid) {
+      close(sock);
+      signal(SIGCHLD, SIG_DFL);
+      forkpool_child(gwion->data->forkpool);
+      zygote_child(gwion, fd);
+      return GW_OK;
+    }
+    close(fd);
+    if(pid < 0)
+      break;
+  }
+  close(sock);
+  unlink(path);
+  return GW_ERROR;
+}
+#endif
@@ -0,0 +1,23 @@
+#include "gwion_util.h"
+#include "gwion_ast.h"
+#include "gwion_env.h"
+#include "vm.h"
+#include "instr.h"
+#include "gwion.h"
+#include "object.h"
+#include "operator.h"
+#include "import.h"
+#include "gwi.h"
+#include "forkpool.h"
+
+static SFUN(fork_instances) {
+  *(m_uint*)RETURN = forkpool_instances(shred->info->vm->gwion->data->forkpool);
+}
+
+GWION_IMPORT(fork_reuse) {
+  GWI_OB(gwi_class_ini(gwi, "ForkReuse", NULL))
+    GWI_BB(gwi_func_ini(gwi, "int", "instances"))
+    GWI_BB(gwi_func_end(gwi, fork_instances, ae_flag_static))
+  GWI_BB(gwi_class_end(gwi))
+  return GW_OK;
+}
@@ -1,5 +1,5 @@
 #!/bin/bash
-# [test] #79
+# [test] #80
 
 n=0
 [ "$1" ] && n="$1"
@@ -1,5 +1,5 @@
 #!/bin/bash
-# [test] #24
+# [test] #30
 
 n=0
 [ "$1" ] && n="$1"
@@ -36,6 +36,72 @@ run "$n" "out channels (short)" "-o 2" "file"
 n=$((n+1))
 run "$n" "samplerate (short)" "-s 44100" "file"
 
+# block size
+n=$((n+1))
+run "$n" "block size (short)" "-b 64" "file"
+
+# fork threads
+n=$((n+1))
+run "$n" "fork threads (short)" "-t 2" "file"
+
+# parallel shreds
+n=$((n+1))
+run "$n" "jobs (short)" "-j 2" "file"
+
+# shred budget
+n=$((n+1))
+run "$n" "budget (short)" "-B 100000" "file"
+
+# shred budget on helper threads: the spinning shred is reported,
+# the others keep their stack and finish
+n=$((n+1))
+SRC=./tmp_budget.gw
+cat << EOF > "$SRC"
+fun void work() {
+  var int n;
+  for(var int i; i < 8; ++i) {
+    while(n < 100 * (i + 1))
+      1 +=> n;
+    samp => now;
+  }
+  <<< "done ", n >>>;
+}
+for(var int i; i < 15; ++i)
+  spork work();
+spork { while(true) {} };
+ms => now;
+EOF
+./gwion -d "$DRIVER" -j 2 -B 1000 "$SRC" &> tmp_budget.log
+if grep -q BudgetExceeded tmp_budget.log && [ "$(grep -c "done 800" tmp_budget.log)" -eq 15 ]
+then echo "ok $(printf "% 4i" "$n") budget with jobs"
+else echo "not ok $(printf "% 4i" "$n") budget with jobs"
+fi
+rm "$SRC" tmp_budget.log
+
+# block mode renders the same samples, shreds wake on the same frames
+n=$((n+1))
+SRC=./tmp_block.gw
+cat << EOF > "$SRC"
+var Impulse imp => var Gain g => dac;
+var Step step => g;
+0.5 => g.gain;
+var float v;
+for(var int k; k < 40; ++k) {
+  1. +=> v;
+  v => imp.next;
+  v * 0.25 => step.next;
+  (k % 7 + 1)::samp => now;
+  <<< g.last() >>>;
+}
+EOF
+./gwion -d "$DRIVER" "$SRC" &> tmp_sample.log
+./gwion -d "$DRIVER" -b 16 "$SRC" &> tmp_block.log
+if [ -s tmp_sample.log ] && cmp -s tmp_sample.log tmp_block.log
+then echo "ok $(printf "% 4i" "$n") block output matches"
+else echo "not ok $(printf "% 4i" "$n") block output matches"
+fi
+rm "$SRC" tmp_sample.log tmp_block.log
+
 # wrong file
 n=$((n+1))
 run "$n" "wrong file" "non_existant_file:with_args" "file"